@@ -0,0 +1,77 @@
+#ifndef ATOMIC_COLUMN_H
+#define ATOMIC_COLUMN_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Столбец атомарных значений для World. std::vector<std::atomic<T>> не
+// умеет push_back и копирование, поэтому здесь рост сделан вручную.
+// Рост и копирование - не потокобезопасны (мир в это время не делится
+// с другими потоками); доступ к элементам - атомарный.
+template <typename T>
+class AtomicColumn {
+public:
+    AtomicColumn() = default;
+
+    AtomicColumn(const AtomicColumn& other) { copyFrom(other); }
+    AtomicColumn& operator=(const AtomicColumn& other) {
+        if (this != &other) {
+            count = 0;
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    AtomicColumn(AtomicColumn&& other) noexcept { swap(other); }
+    AtomicColumn& operator=(AtomicColumn&& other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    size_t size() const { return count; }
+
+    void reserve(size_t wanted) {
+        if (wanted <= cap) return;
+        std::unique_ptr<std::atomic<T>[]> grown(new std::atomic<T>[wanted]);
+        for (size_t i = 0; i < count; ++i) {
+            grown[i].store(items[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        items = std::move(grown);
+        cap = wanted;
+    }
+
+    void push_back(T value) {
+        if (count == cap) reserve(std::max<size_t>(16, cap * 2));
+        items[count++].store(value, std::memory_order_relaxed);
+    }
+
+    // Уменьшение без переноса (для сжатия на месте)
+    void truncate(size_t newCount) { count = std::min(count, newCount); }
+
+    std::atomic<T>& operator[](size_t i) { return items[i]; }
+    const std::atomic<T>& operator[](size_t i) const { return items[i]; }
+
+private:
+    std::unique_ptr<std::atomic<T>[]> items;
+    size_t count = 0;
+    size_t cap = 0;
+
+    void copyFrom(const AtomicColumn& other) {
+        reserve(other.count);
+        for (size_t i = 0; i < other.count; ++i) {
+            items[i].store(other.items[i].load(std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+        }
+        count = other.count;
+    }
+
+    void swap(AtomicColumn& other) noexcept {
+        std::swap(items, other.items);
+        std::swap(count, other.count);
+        std::swap(cap, other.cap);
+    }
+};
+
+#endif
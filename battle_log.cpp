@@ -0,0 +1,140 @@
+#include "battle_log.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+std::atomic<uint64_t> nextLogId{1};
+
+// Буферы текущего потока для каждого журнала, в который он писал
+thread_local std::vector<std::pair<uint64_t, void*>> threadBuffers;
+
+}
+
+BattleLog::BattleLog(LogDestination destination, const std::string& path,
+                     std::shared_ptr<const NPCStatics> statics,
+                     std::mutex* outputMutex, size_t perThreadCapacity)
+    : destination(destination), statics(std::move(statics)),
+      outputMutex(outputMutex), perThreadCapacity(perThreadCapacity),
+      id(nextLogId++) {
+    if (destination == LogDestination::FILE) {
+        file.open(path, std::ios::out | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("cannot open battle log: " + path);
+        }
+    }
+    if (destination != LogDestination::DISCARD) {
+        writer = std::thread(&BattleLog::writerLoop, this);
+    }
+}
+
+BattleLog::~BattleLog() {
+    stop();
+}
+
+BattleLog::ThreadBuffer& BattleLog::localBuffer() {
+    for (const auto& entry : threadBuffers) {
+        if (entry.first == id) return *static_cast<ThreadBuffer*>(entry.second);
+    }
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->records.reserve(256);
+    ThreadBuffer* raw = buffer.get();
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.push_back(std::move(buffer));
+    }
+    threadBuffers.emplace_back(id, raw);
+    return *raw;
+}
+
+void BattleLog::record(const BattleRecord& rec) {
+    if (destination == LogDestination::DISCARD) return;
+
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.records.size() >= perThreadCapacity) {
+        droppedCount++;
+        return;
+    }
+    buffer.records.push_back(rec);
+}
+
+void BattleLog::drain() {
+    std::lock_guard<std::mutex> flushLock(flushMutex);
+
+    std::vector<ThreadBuffer*> current;
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (const auto& buffer : buffers) current.push_back(buffer.get());
+    }
+
+    std::vector<BattleRecord> batch;
+    std::vector<BattleRecord> taken;
+    for (ThreadBuffer* buffer : current) {
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            taken.swap(buffer->records);
+        }
+        batch.insert(batch.end(), taken.begin(), taken.end());
+        taken.clear();
+    }
+    if (batch.empty()) return;
+
+    // Записи разных потоков упорядочиваем по тику
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const BattleRecord& a, const BattleRecord& b) { return a.tick < b.tick; });
+
+    std::string text;
+    text.reserve(batch.size() * 48);
+    for (const auto& rec : batch) {
+        text += "BATTLE: ";
+        statics->appendName(text, rec.attacker);
+        text += " vs ";
+        statics->appendName(text, rec.defender);
+        text += " -> ";
+        statics->appendName(text, rec.attackerWins ? rec.attacker : rec.defender);
+        text += " wins!\n";
+    }
+
+    if (destination == LogDestination::FILE) {
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        file.flush();
+    } else if (outputMutex) {
+        std::lock_guard<std::mutex> lock(*outputMutex);
+        std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+        std::cout.flush();
+    } else {
+        std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+        std::cout.flush();
+    }
+    writtenCount += batch.size();
+}
+
+void BattleLog::flush() {
+    if (destination != LogDestination::DISCARD) drain();
+}
+
+void BattleLog::writerLoop() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeCV.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+void BattleLog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCV.notify_all();
+    if (writer.joinable()) writer.join();
+
+    flush();
+}
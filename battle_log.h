@@ -0,0 +1,91 @@
+#ifndef BATTLE_LOG_H
+#define BATTLE_LOG_H
+
+#include "world.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Куда пишется журнал боев
+enum class LogDestination {
+    STDOUT,
+    FILE,
+    DISCARD
+};
+
+// Компактная запись о бое: только номера NPC, имена подставляет писатель
+// Участники - номера NPCStatics::id, они не меняются при сжатии мира
+struct BattleRecord {
+    uint32_t tick;
+    NPCId attacker;
+    NPCId defender;
+    uint32_t attackerWins;
+};
+
+// Асинхронный журнал боев. Потоки боев складывают записи в свои буферы
+// (мьютекс буфера почти никогда не оспаривается), фоновый поток
+// периодически забирает их пачками, форматирует и пишет одним вызовом.
+// При переполнении буфера потока запись отбрасывается и считается.
+//
+// statics - статика мира до первого сжатия, в ней индекс равен id.
+class BattleLog {
+public:
+    BattleLog(LogDestination destination, const std::string& path,
+              std::shared_ptr<const NPCStatics> statics,
+              std::mutex* outputMutex = nullptr,
+              size_t perThreadCapacity = 1 << 16);
+    ~BattleLog();
+
+    BattleLog(const BattleLog&) = delete;
+    BattleLog& operator=(const BattleLog&) = delete;
+
+    void record(const BattleRecord& rec);
+
+    // Синхронно выписывает все накопленные записи
+    void flush();
+
+    // Останавливает фоновый поток (с финальной выпиской)
+    void stop();
+
+    uint64_t written() const { return writtenCount; }
+    uint64_t dropped() const { return droppedCount; }
+
+private:
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<BattleRecord> records;
+    };
+
+    static constexpr int FLUSH_INTERVAL_MS = 50;
+
+    LogDestination destination;
+    std::ofstream file;
+    std::shared_ptr<const NPCStatics> statics;
+    std::mutex* outputMutex;
+    size_t perThreadCapacity;
+    const uint64_t id;
+
+    std::mutex buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    std::mutex flushMutex;  // одна выписка за раз
+    std::mutex wakeMutex;
+    std::condition_variable wakeCV;
+    bool stopping = false;
+    std::thread writer;
+
+    std::atomic<uint64_t> writtenCount{0};
+    std::atomic<uint64_t> droppedCount{0};
+
+    ThreadBuffer& localBuffer();
+    void writerLoop();
+    void drain();
+};
+
+#endif
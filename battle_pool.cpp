@@ -0,0 +1,149 @@
+#include "battle_pool.h"
+#include "rng.h"
+
+BattlePool::BattlePool(size_t workerCount, size_t capacity, Handler handler)
+    : inbox(capacity), handler(std::move(handler)) {
+    if (workerCount == 0) workerCount = 1;
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < workerCount; ++i) {
+        threads.emplace_back(&BattlePool::workerLoop, this, i);
+    }
+}
+
+BattlePool::~BattlePool() {
+    stop();
+}
+
+size_t BattlePool::submitBatch(const BattleTask* tasks, size_t count) {
+    if (stopping || count == 0) return 0;
+
+    // Счетчики увеличиваем заранее, чтобы поток не закончил задачу раньше
+    unfinishedCount += count;
+    queuedCount += count;
+
+    size_t accepted = inbox.pushBatch(tasks, count);
+    if (accepted < count) {
+        queuedCount -= count - accepted;
+        if ((unfinishedCount -= count - accepted) == 0) {
+            { std::lock_guard<std::mutex> lock(sleepMutex); }
+            idleCV.notify_all();
+        }
+    }
+
+    if (accepted > 0) {
+        // Одно пробуждение на всю пачку
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        workCV.notify_all();
+    }
+    return accepted;
+}
+
+void BattlePool::waitIdle() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    idleCV.wait(lock, [this]() { return unfinishedCount == 0 || stopping; });
+}
+
+void BattlePool::pause() {
+    paused = true;
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    idleCV.wait(lock, [this]() { return busyCount == 0 || stopping; });
+}
+
+void BattlePool::resume() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        paused = false;
+    }
+    workCV.notify_all();
+}
+
+void BattlePool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    workCV.notify_all();
+    idleCV.notify_all();
+
+    for (auto& thread : threads) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+bool BattlePool::popLocal(size_t id, BattleTask& task) {
+    Worker& worker = *workers[id];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) return false;
+
+    task = worker.tasks.back();
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool BattlePool::refill(size_t id, BattleTask& task) {
+    BattleTask batch[REFILL_BATCH];
+    size_t count = inbox.popBatch(batch, REFILL_BATCH);
+    if (count == 0) return false;
+
+    // Первую задачу выполняем сразу, остальные доступны для кражи
+    task = batch[0];
+    if (count > 1) {
+        Worker& worker = *workers[id];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.insert(worker.tasks.end(), batch + 1, batch + count);
+    }
+    return true;
+}
+
+bool BattlePool::steal(size_t id, BattleTask& task) {
+    for (size_t k = 1; k < workers.size(); ++k) {
+        Worker& victim = *workers[(id + k) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+
+        task = victim.tasks.front();
+        victim.tasks.pop_front();
+        stolenCount++;
+        return true;
+    }
+    return false;
+}
+
+void BattlePool::workerLoop(size_t id) {
+    // У каждого потока пула свой воспроизводимый поток случайности
+    Rng::bindThreadStream(Rng::BATTLE_STREAM_BASE + id);
+
+    while (!stopping) {
+        BattleTask task;
+
+        // busyCount растет до проверки paused: pause() либо увидит этот
+        // поток занятым и дождется его, либо поток увидит паузу
+        busyCount++;
+        if (!paused && (popLocal(id, task) || refill(id, task) || steal(id, task))) {
+            queuedCount--;
+            handler(task);
+            executedCount++;
+            leaveBusy();
+
+            if (--unfinishedCount == 0) {
+                { std::lock_guard<std::mutex> lock(sleepMutex); }
+                idleCV.notify_all();
+            }
+            continue;
+        }
+        leaveBusy();
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        workCV.wait(lock, [this]() { return (queuedCount > 0 && !paused) || stopping; });
+    }
+}
+
+void BattlePool::leaveBusy() {
+    if (--busyCount == 0 && paused) {
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        idleCV.notify_all();
+    }
+}
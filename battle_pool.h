@@ -0,0 +1,99 @@
+#ifndef BATTLE_POOL_H
+#define BATTLE_POOL_H
+
+#include "world.h"
+#include "bounded_ring.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct BattleTask {
+    NPCHandle attacker;
+    NPCHandle defender;
+};
+
+// Пул потоков для разрешения боев. Задачи приходят пачками через
+// lock-free кольцо inbox; поток перекладывает часть пачки в свою очередь,
+// берет задачи с ее конца, а остальные потоки воруют с начала.
+// Кольцо ограничено capacity, лишние задачи отбрасываются (пара все
+// равно будет найдена на следующем тике).
+class BattlePool {
+public:
+    using Handler = std::function<void(const BattleTask&)>;
+
+    BattlePool(size_t workerCount, size_t capacity, Handler handler);
+    ~BattlePool();
+
+    BattlePool(const BattlePool&) = delete;
+    BattlePool& operator=(const BattlePool&) = delete;
+
+    // Публикует пачку задач с одним пробуждением потоков.
+    // Возвращает число принятых задач.
+    size_t submitBatch(const BattleTask* tasks, size_t count);
+    size_t submitBatch(const std::vector<BattleTask>& tasks) {
+        return submitBatch(tasks.data(), tasks.size());
+    }
+
+    // false, если очередь заполнена и задача отброшена
+    bool submit(const BattleTask& task) { return submitBatch(&task, 1) == 1; }
+
+    // Ждет, пока все поставленные задачи будут выполнены
+    void waitIdle();
+
+    // Приостанавливает выдачу задач и ждет, пока потоки выйдут из
+    // обработчика; поставленные задачи остаются в очереди до resume().
+    // Между pause и resume обработчик не вызывается (сжатие мира).
+    void pause();
+    void resume();
+
+    // Останавливает потоки; невыполненные задачи отбрасываются
+    void stop();
+
+    size_t workerCount() const { return workers.size(); }
+    size_t queued() const { return queuedCount; }
+    size_t inboxDepth() const { return inbox.depth(); }
+    uint64_t executed() const { return executedCount; }
+    uint64_t stolen() const { return stolenCount; }
+    uint64_t dropped() const { return inbox.dropped(); }
+    uint64_t backpressured() const { return inbox.backpressured(); }
+
+private:
+    // Сколько задач поток забирает из inbox за раз
+    static constexpr size_t REFILL_BATCH = 32;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<BattleTask> tasks;
+    };
+
+    BoundedRing<BattleTask> inbox;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    Handler handler;
+
+    std::mutex sleepMutex;
+    std::condition_variable workCV;
+    std::condition_variable idleCV;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> paused{false};
+    std::atomic<size_t> busyCount{0};        // потоков между взятием задачи и ее концом
+    std::atomic<size_t> queuedCount{0};      // в inbox и в очередях потоков
+    std::atomic<size_t> unfinishedCount{0};  // еще не выполнены
+
+    std::atomic<uint64_t> executedCount{0};
+    std::atomic<uint64_t> stolenCount{0};
+
+    void workerLoop(size_t id);
+    void leaveBusy();
+    bool popLocal(size_t id, BattleTask& task);
+    bool refill(size_t id, BattleTask& task);
+    bool steal(size_t id, BattleTask& task);
+};
+
+#endif
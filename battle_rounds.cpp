@@ -0,0 +1,34 @@
+#include "battle_rounds.h"
+#include <algorithm>
+
+void BattleRoundPlanner::plan(const std::vector<BattlePair>& pairs, size_t npcCount) {
+    if (nextRound.size() < npcCount) nextRound.resize(npcCount, 0);
+    roundOf.resize(pairs.size());
+    battles.resize(pairs.size());
+
+    // Пара идет в раунд после последних боев обоих участников
+    uint32_t rounds = 0;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        const BattlePair& p = pairs[i];
+        uint32_t r = std::max(nextRound[p.attacker], nextRound[p.defender]);
+        roundOf[i] = r;
+        nextRound[p.attacker] = r + 1;
+        nextRound[p.defender] = r + 1;
+        rounds = std::max(rounds, r + 1);
+    }
+
+    // Сортировка подсчетом по раундам; внутри раунда порядок списка
+    roundStart.assign(rounds + 1, 0);
+    for (uint32_t r : roundOf) roundStart[r + 1]++;
+    for (uint32_t r = 0; r < rounds; ++r) roundStart[r + 1] += roundStart[r];
+    std::vector<uint32_t> fill(roundStart.begin(), roundStart.end() - 1);
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        battles[fill[roundOf[i]]++] = {pairs[i], static_cast<uint32_t>(i)};
+    }
+
+    // Сбрасываем только затронутых NPC, а не весь массив
+    for (const BattlePair& p : pairs) {
+        nextRound[p.attacker] = 0;
+        nextRound[p.defender] = 0;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef BATTLE_ROUNDS_H
+#define BATTLE_ROUNDS_H
+
+#include "broadphase.h"
+#include <cstdint>
+#include <vector>
+
+// Бой из плана: пара и ее номер в списке пар тика (ключ для кубиков)
+struct PlannedBattle {
+    BattlePair pair;
+    uint32_t index;
+};
+
+// Раскладывает бои тика по раундам без конфликтов (жадная раскраска
+// ребер графа контактов). В одном раунде NPC участвует не более одного
+// раза, поэтому бои раунда разрешаются параллельно без блокировок.
+// Бои каждого NPC попадают в раунды в том же порядке, что и в списке
+// пар, - итог совпадает с последовательным разрешением по списку.
+class BattleRoundPlanner {
+public:
+    void plan(const std::vector<BattlePair>& pairs, size_t npcCount);
+
+    size_t roundCount() const { return roundStart.empty() ? 0 : roundStart.size() - 1; }
+    size_t battleCount() const { return battles.size(); }
+
+    // Бои раунда r: [roundBegin(r), roundEnd(r))
+    const PlannedBattle* roundBegin(size_t r) const { return battles.data() + roundStart[r]; }
+    const PlannedBattle* roundEnd(size_t r) const { return battles.data() + roundStart[r + 1]; }
+    size_t roundSize(size_t r) const { return roundStart[r + 1] - roundStart[r]; }
+
+private:
+    std::vector<uint32_t> nextRound;  // первый свободный раунд NPC
+    std::vector<uint32_t> roundOf;    // раунд каждой пары
+    std::vector<uint32_t> roundStart;
+    std::vector<PlannedBattle> battles;
+};
+
+#endif
@@ -0,0 +1,381 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "npc.h"
+#include "factory.h"
+#include "world.h"
+#include "broadphase.h"
+#include "battle_pool.h"
+#include "battle_rounds.h"
+#include "battle_log.h"
+#include "kill_kernel.h"
+#include "rng.h"
+#include "thread_pool.h"
+#include "game.h"
+
+// Бенчмарки lab07: отдельные операции (micro) и целые тики (macro).
+// Результат - CSV (по умолчанию) или JSON в stdout, по строке на замер.
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchResult {
+    std::string name;
+    size_t npcs = 0;
+    std::string density;
+    int mapSide = 0;
+    uint64_t iterations = 0;
+    uint64_t items = 0;       // сколько единиц работы (NPC, пар, боев)
+    double seconds = 0;
+    std::string note{};
+};
+
+struct Density {
+    const char* name;
+    double npcsPerCell;  // NPC на клетку карты
+};
+
+static const Density DENSITIES[] = {
+    {"sparse", 0.001},
+    {"medium", 0.01},
+    {"dense", 0.1},
+};
+
+static int mapSideFor(size_t npcs, double npcsPerCell) {
+    return std::max(10, static_cast<int>(std::sqrt(npcs / npcsPerCell)));
+}
+
+// Повторяет body, пока не наберется minSeconds (но не меньше одного раза)
+static void measure(BenchResult& result, double minSeconds,
+                    const std::function<uint64_t()>& body) {
+    auto start = Clock::now();
+    do {
+        result.items += body();
+        result.iterations++;
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (result.seconds < minSeconds);
+}
+
+static World makeWorld(size_t npcs, int mapSide) {
+    World world;
+    world.reserve(npcs);
+    for (const auto& npc : NPCFactory::createRandomNPCs(static_cast<int>(npcs),
+                                                        mapSide, mapSide)) {
+        world.add(*npc);
+    }
+    return world;
+}
+
+static BenchResult benchSpawn(size_t npcs, double minSeconds) {
+    BenchResult r{"spawn", npcs, "-", 1000};
+    measure(r, minSeconds, [npcs]() {
+        auto created = NPCFactory::createRandomNPCs(static_cast<int>(npcs), 1000, 1000);
+        return static_cast<uint64_t>(created.size());
+    });
+    return r;
+}
+
+static BenchResult benchSpawnArena(size_t npcs, double minSeconds) {
+    BenchResult r{"spawn_arena", npcs, "-", 1000};
+    NPCArena arena;
+    measure(r, minSeconds, [npcs, &arena]() {
+        arena.clear();  // блоки прошлой итерации используются заново
+        NPCFactory::createRandomNPCs(arena, static_cast<int>(npcs), 1000, 1000);
+        return static_cast<uint64_t>(arena.size());
+    });
+    r.note = "slabs=" + std::to_string(arena.slabCount());
+    return r;
+}
+
+static BenchResult benchMoveObjects(size_t npcs, double minSeconds) {
+    BenchResult r{"move_npc", npcs, "-", 1000};
+    auto objects = NPCFactory::createRandomNPCs(static_cast<int>(npcs), 1000, 1000);
+    measure(r, minSeconds, [&objects]() {
+        for (auto& npc : objects) npc->move(1000, 1000);
+        return static_cast<uint64_t>(objects.size());
+    });
+    return r;
+}
+
+static BenchResult benchMoveWorld(size_t npcs, double minSeconds) {
+    BenchResult r{"move_world", npcs, "-", 1000};
+    World world = makeWorld(npcs, 1000);
+    measure(r, minSeconds, [&world]() {
+        for (size_t i = 0; i < world.size(); ++i) world.move(world.handle(i), 1000, 1000);
+        return static_cast<uint64_t>(world.size());
+    });
+    return r;
+}
+
+static BenchResult benchBroadphase(BroadphaseKind kind, size_t npcs,
+                                   const Density& density, double minSeconds) {
+    auto broadphase = makeBroadphase(kind);
+    int side = mapSideFor(npcs, density.npcsPerCell);
+    BenchResult r{std::string("detect_") + broadphase->name(), npcs, density.name, side};
+
+    // Полный перебор на больших N занимает минуты - пропускаем
+    if (kind == BroadphaseKind::BRUTE_FORCE && npcs > 20000) {
+        r.note = "skipped";
+        return r;
+    }
+
+    World world = makeWorld(npcs, side);
+    std::vector<BattlePair> pairs;
+    measure(r, minSeconds, [&]() {
+        broadphase->findPairs(world, side, side, pairs);
+        return static_cast<uint64_t>(world.size());
+    });
+    r.note = "pairs=" + std::to_string(pairs.size());
+    return r;
+}
+
+static constexpr size_t MAX_BATTLE_PAIRS = size_t{1} << 22;
+
+// Разрешение боев тика, как в Game: проверка жизни, кубики, World::tryFight,
+// счетчики живых и журнал боев. Мир с плотными контактами и пары
+// ищутся один раз; перед каждым прогоном мир копируется заново (вне замера).
+struct BattleArena {
+    World world;
+    std::vector<BattlePair> pairs;
+    int side = 0;
+};
+
+static BattleArena makeBattleArena(size_t npcs) {
+    BattleArena arena;
+    arena.side = mapSideFor(npcs, DENSITIES[2].npcsPerCell);
+    arena.world = makeWorld(npcs, arena.side);
+    makeBroadphase(BroadphaseKind::UNIFORM_GRID)->findPairs(arena.world, arena.side, arena.side,
+                                                          arena.pairs);
+    // На 1M NPC плотная карта дает ~45M пар: очередь пула на них не поместится
+    if (arena.pairs.size() > MAX_BATTLE_PAIRS) arena.pairs.resize(MAX_BATTLE_PAIRS);
+    return arena;
+}
+
+static BenchResult benchBattles(const BattleArena& arena, BattleScheduler scheduler,
+                                int workers, double minSeconds) {
+    const bool rounds = scheduler == BattleScheduler::ROUNDS;
+    BenchResult r{rounds ? "battles_rounds" : "battles_pool", arena.world.size(), "dense",
+                  arena.side};
+
+    World world;
+    std::array<std::atomic<size_t>, NPC_TYPE_COUNT> aliveCounts{};
+    std::atomic<uint64_t> fought{0};
+    BattleLog log(LogDestination::DISCARD, "", arena.world.sharedStatics(), nullptr);
+    auto fight = [&](NPCHandle attacker, NPCHandle defender, bool attackerWins) {
+        if (!world.isAlive(attacker) || !world.isAlive(defender)) return;
+        world.tryFight(attacker, defender, attackerWins, [&](NPCHandle loser) {
+            aliveCounts[static_cast<size_t>(world.getType(loser))].fetch_sub(
+                1, std::memory_order_relaxed);
+            fought++;
+            log.record({0, world.stableId(attacker), world.stableId(defender),
+                        attackerWins ? 1u : 0u});
+        });
+    };
+
+    ThreadPool threads(static_cast<size_t>(workers));
+    BattleRoundPlanner planner;
+    std::vector<BattleTask> batch;
+    std::unique_ptr<BattlePool> pool;
+    if (!rounds) {
+        pool = std::make_unique<BattlePool>(static_cast<size_t>(workers), arena.pairs.size(),
+                                            [&](const BattleTask& task) {
+            Xoshiro256& gen = Rng::local();
+            fight(task.attacker, task.defender, gen.uniform(1, 6) > gen.uniform(1, 6));
+        });
+    }
+
+    do {
+        world = arena.world;
+        for (auto& count : aliveCounts) count = 0;
+        for (size_t i = 0; i < world.size(); ++i) {
+            aliveCounts[static_cast<size_t>(world.getType(world.handle(i)))]++;
+        }
+
+        auto start = Clock::now();
+        if (rounds) {
+            planner.plan(arena.pairs, world.size());
+            for (size_t round = 0; round < planner.roundCount(); ++round) {
+                const PlannedBattle* battles = planner.roundBegin(round);
+                threads.parallelFor(planner.roundSize(round), 256, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        fight(world.handle(battles[i].pair.attacker),
+                              world.handle(battles[i].pair.defender),
+                              attackerWinsDice(splitmix64(battles[i].index)));
+                    }
+                });
+            }
+        } else {
+            batch.clear();
+            for (const BattlePair& pair : arena.pairs) {
+                batch.push_back({world.handle(pair.attacker), world.handle(pair.defender)});
+            }
+            pool->submitBatch(batch);
+            pool->waitIdle();
+        }
+        r.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        r.items += arena.pairs.size();
+        r.iterations++;
+    } while (r.seconds < minSeconds);
+
+    std::ostringstream note;
+    note << "workers=" << workers << ";pairs=" << arena.pairs.size()
+         << ";fought_per_run=" << fought / r.iterations;
+    if (rounds) note << ";rounds=" << planner.roundCount();
+    r.note = note.str();
+    return r;
+}
+
+// Полный тик: движение, поиск пар и бои (Game::runHeadless)
+static BenchResult benchTicks(size_t npcs, const Density& density, uint64_t ticks,
+                              BroadphaseKind kind = BroadphaseKind::UNIFORM_GRID) {
+    int side = mapSideFor(npcs, density.npcsPerCell);
+    const char* name = kind == BroadphaseKind::VERLET ? "tick_verlet"
+                     : kind == BroadphaseKind::SHARDED ? "tick_sharded" : "tick";
+    BenchResult r{name, npcs, density.name, side};
+
+    GameConfig config;
+    config.npcCount = static_cast<int>(npcs);
+    config.mapX = side;
+    config.mapY = side;
+    config.seed = 1;
+    config.broadphase = kind;
+    config.battleLog = LogDestination::DISCARD;
+
+    std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+    Game game(config);
+    SimulationReport report = game.runHeadless(ticks);
+    std::cout.rdbuf(oldBuf);
+
+    r.iterations = report.ticks;
+    r.items = report.ticks;
+    r.seconds = report.totalSeconds;
+    std::ostringstream note;
+    note << "move_ms=" << report.moveSeconds * 1000.0
+         << ";detect_ms=" << report.detectSeconds * 1000.0
+         << ";battle_ms=" << report.battleSeconds * 1000.0
+         << ";fought=" << report.battlesFought;
+    if (report.broadphase.shards > 0) {
+        note << ";shards=" << report.broadphase.shards
+             << ";migrations=" << report.broadphase.migrations
+             << ";halo_per_tick=" << report.broadphase.haloEntries / report.broadphase.calls;
+    } else if (report.broadphase.rebuilds > 0) {
+        note << ";rebuilds=" << report.broadphase.rebuilds
+             << ";fallbacks=" << report.broadphase.fallbacks
+             << ";max_candidates=" << report.broadphase.maxCandidates;
+    }
+    r.note = note.str();
+    return r;
+}
+
+static void printCsvHeader() {
+    std::cout << "benchmark,npcs,density,map,iterations,items,total_ms,ns_per_item,items_per_sec,note\n";
+}
+
+static void printCsv(const BenchResult& r) {
+    double nsPerItem = r.items ? r.seconds * 1e9 / r.items : 0;
+    double perSec = r.seconds > 0 ? r.items / r.seconds : 0;
+    std::cout << r.name << ',' << r.npcs << ',' << r.density << ',' << r.mapSide << ','
+              << r.iterations << ',' << r.items << ',' << r.seconds * 1000.0 << ','
+              << nsPerItem << ',' << perSec << ',' << r.note << "\n";
+}
+
+static void printJson(const BenchResult& r, bool first) {
+    double nsPerItem = r.items ? r.seconds * 1e9 / r.items : 0;
+    double perSec = r.seconds > 0 ? r.items / r.seconds : 0;
+    std::cout << (first ? "  " : ",\n  ")
+              << "{\"benchmark\":\"" << r.name << "\",\"npcs\":" << r.npcs
+              << ",\"density\":\"" << r.density << "\",\"map\":" << r.mapSide
+              << ",\"iterations\":" << r.iterations << ",\"items\":" << r.items
+              << ",\"total_ms\":" << r.seconds * 1000.0
+              << ",\"ns_per_item\":" << nsPerItem << ",\"items_per_sec\":" << perSec
+              << ",\"note\":\"" << r.note << "\"}";
+}
+
+static std::vector<size_t> parseSizes(const std::string& list) {
+    std::vector<size_t> sizes;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) sizes.push_back(std::stoull(item));
+    }
+    return sizes;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+    bool json = false;
+    double minSeconds = 0.2;
+    uint64_t ticks = 20;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--csv") {
+            json = false;
+        } else if (arg == "--quick") {
+            sizes = {1000};
+            minSeconds = 0.01;
+            ticks = 3;
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            sizes = parseSizes(argv[++i]);
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            minSeconds = std::stod(argv[++i]);
+        } else if (arg == "--ticks" && i + 1 < argc) {
+            ticks = std::stoull(argv[++i]);
+        } else {
+            std::cerr << "Usage: lab07_bench [--csv|--json] [--quick] [--sizes 1000,10000]"
+                         " [--min-time SEC] [--ticks N]\n";
+            return 1;
+        }
+    }
+
+    Rng::setMasterSeed(1);
+    std::cerr << "lab07_bench: kill kernel " << simdLevelName(activeKillKernel()) << "\n";
+
+    std::vector<BenchResult> results;
+    auto run = [&](BenchResult r) {
+        std::cerr << "  " << r.name << " n=" << r.npcs << " " << r.density << "\n";
+        results.push_back(std::move(r));
+    };
+
+    for (size_t n : sizes) {
+        run(benchSpawn(n, minSeconds));
+        run(benchSpawnArena(n, minSeconds));
+        run(benchMoveObjects(n, minSeconds));
+        run(benchMoveWorld(n, minSeconds));
+        for (const Density& density : DENSITIES) {
+            run(benchBroadphase(BroadphaseKind::BRUTE_FORCE, n, density, minSeconds));
+            run(benchBroadphase(BroadphaseKind::UNIFORM_GRID, n, density, minSeconds));
+            run(benchBroadphase(BroadphaseKind::SHARDED, n, density, minSeconds));
+        }
+        {
+            const BattleArena arena = makeBattleArena(n);
+            run(benchBattles(arena, BattleScheduler::ROUNDS, 4, minSeconds));
+            run(benchBattles(arena, BattleScheduler::POOL, 4, minSeconds));
+        }
+        for (const Density& density : DENSITIES) {
+            run(benchTicks(n, density, ticks));
+            run(benchTicks(n, density, ticks, BroadphaseKind::VERLET));
+            run(benchTicks(n, density, ticks, BroadphaseKind::SHARDED));
+        }
+    }
+
+    if (json) {
+        std::cout << "[\n";
+        for (size_t i = 0; i < results.size(); ++i) printJson(results[i], i == 0);
+        std::cout << "\n]\n";
+    } else {
+        printCsvHeader();
+        for (const auto& r : results) printCsv(r);
+    }
+    return 0;
+}
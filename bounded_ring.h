@@ -0,0 +1,120 @@
+#ifndef BOUNDED_RING_H
+#define BOUNDED_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Ограниченная lock-free очередь MPMC (кольцо Вьюкова): у каждой ячейки
+// свой счетчик последовательности, производители и потребители
+// захватывают позиции через CAS и не берут мьютексов.
+template <typename T>
+class BoundedRing {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+
+    alignas(64) std::atomic<uint64_t> droppedCount{0};
+    std::atomic<uint64_t> backpressureCount{0};
+
+    static size_t roundUpPow2(size_t v) {
+        size_t p = 2;
+        while (p < v) p <<= 1;
+        return p;
+    }
+
+public:
+    explicit BoundedRing(size_t capacity)
+        : cells(new Cell[roundUpPow2(capacity)]), mask(roundUpPow2(capacity) - 1) {
+        for (size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedRing(const BoundedRing&) = delete;
+    BoundedRing& operator=(const BoundedRing&) = delete;
+
+    bool tryPush(const T& item) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = item;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // кольцо заполнено
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& item) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    item = cell.value;
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // кольцо пусто
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Публикует пачку; то, что не поместилось, отбрасывается и учитывается
+    // в dropped(), а сама пачка - в backpressured(). Возвращает число принятых.
+    size_t pushBatch(const T* items, size_t count) {
+        size_t pushed = 0;
+        while (pushed < count && tryPush(items[pushed])) {
+            pushed++;
+        }
+        if (pushed < count) {
+            droppedCount.fetch_add(count - pushed, std::memory_order_relaxed);
+            backpressureCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return pushed;
+    }
+
+    size_t popBatch(T* out, size_t maxCount) {
+        size_t popped = 0;
+        while (popped < maxCount && tryPop(out[popped])) {
+            popped++;
+        }
+        return popped;
+    }
+
+    // Приблизительная глубина (точная, если нет параллельных операций)
+    size_t depth() const {
+        size_t enq = enqueuePos.load(std::memory_order_relaxed);
+        size_t deq = dequeuePos.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+    uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+    uint64_t backpressured() const { return backpressureCount.load(std::memory_order_relaxed); }
+};
+
+#endif
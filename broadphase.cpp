@@ -0,0 +1,259 @@
+#include "broadphase.h"
+#include "kill_kernel.h"
+#include "shards.h"
+#include <algorithm>
+#include <cmath>
+
+void BruteForceBroadphase::findPairs(const World& world,
+                                     int, int,
+                                     std::vector<BattlePair>& out) {
+    out.clear();
+    const auto& xs = world.xs();
+    const auto& ys = world.ys();
+    const auto& kill = world.killDistances();
+
+    const size_t count = world.size();
+    counters.calls++;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!world.isAlive(i)) continue;
+        counters.candidatesChecked += count - i - 1;
+
+        // Кандидаты j > i проверяются блоками векторным ядром
+        for (size_t block = i + 1; block < count; block += KILL_BLOCK) {
+            size_t n = std::min(KILL_BLOCK, count - block);
+            uint32_t hits = killMask(xs[i], ys[i], kill[i], &xs[block], &ys[block], n);
+
+            while (hits) {
+                size_t j = block + static_cast<size_t>(lowestBit(hits));
+                hits &= hits - 1;
+                if (world.isAlive(j)) {
+                    out.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(j)});
+                }
+            }
+        }
+    }
+}
+
+void UniformGridBroadphase::findPairs(const World& world,
+                                      int mapX, int mapY,
+                                      std::vector<BattlePair>& out) {
+    findPairsWithin(world, mapX, mapY, 0, out);
+}
+
+void UniformGridBroadphase::findPairsWithin(const World& world,
+                                            int mapX, int mapY, int extraRange,
+                                            std::vector<BattlePair>& out) {
+    out.clear();
+    counters.calls++;
+    const auto& xs = world.xs();
+    const auto& ys = world.ys();
+    const auto& kill = world.killDistances();
+    const size_t count = world.size();
+
+    // Размер ячейки - максимальная дистанция убийства среди живых,
+    // тогда все жертвы NPC лежат в соседних 3x3 ячейках
+    int cellSize = 1;
+    size_t aliveCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!world.isAlive(i)) continue;
+        cellSize = std::max(cellSize, kill[i] + extraRange);
+        aliveCount++;
+    }
+    if (aliveCount < 2) return;
+
+    mapX = std::max(mapX, 1);
+    mapY = std::max(mapY, 1);
+
+    // Не даем сетке разрастись сильнее числа NPC на больших картах
+    const double maxCells = std::max<double>(1024.0, 4.0 * aliveCount);
+    if (static_cast<double>(mapX / cellSize + 1) * (mapY / cellSize + 1) > maxCells) {
+        int minSize = static_cast<int>(std::ceil(
+            std::sqrt(static_cast<double>(mapX) * mapY / maxCells)));
+        cellSize = std::max(cellSize, minSize);
+    }
+
+    const int gridW = mapX / cellSize + 1;
+    const int gridH = mapY / cellSize + 1;
+    const size_t cellCount = static_cast<size_t>(gridW) * gridH;
+
+    auto cellCoord = [cellSize](int v, int cells) {
+        int c = v / cellSize;
+        if (c < 0) c = 0;
+        if (c >= cells) c = cells - 1;
+        return c;
+    };
+
+    // Сортировка подсчетом: внутри ячейки индексы идут по возрастанию
+    cellStart.assign(cellCount + 1, 0);
+    npcCell.assign(count, UINT32_MAX);
+    for (size_t i = 0; i < count; ++i) {
+        if (!world.isAlive(i)) continue;
+        uint32_t c = static_cast<uint32_t>(cellCoord(ys[i], gridH) * gridW +
+                                           cellCoord(xs[i], gridW));
+        npcCell[i] = c;
+        cellStart[c + 1]++;
+    }
+    for (size_t c = 0; c < cellCount; ++c) {
+        cellStart[c + 1] += cellStart[c];
+    }
+    cellEntries.resize(aliveCount);
+    cellX.resize(aliveCount);
+    cellY.resize(aliveCount);
+    std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        if (npcCell[i] != UINT32_MAX) {
+            uint32_t slot = fill[npcCell[i]]++;
+            cellEntries[slot] = static_cast<uint32_t>(i);
+            cellX[slot] = xs[i];
+            cellY[slot] = ys[i];
+        }
+    }
+
+    // Проверяем только соседние ячейки
+    uint64_t tested = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (npcCell[i] == UINT32_MAX) continue;
+
+        const int cx = static_cast<int>(npcCell[i] % gridW);
+        const int cy = static_cast<int>(npcCell[i] / gridW);
+
+        for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, gridH - 1); ++ny) {
+            for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, gridW - 1); ++nx) {
+                const size_t c = static_cast<size_t>(ny) * gridW + nx;
+                for (uint32_t block = cellStart[c]; block < cellStart[c + 1];
+                     block += KILL_BLOCK) {
+                    size_t n = std::min<size_t>(KILL_BLOCK, cellStart[c + 1] - block);
+                    tested += n;
+                    uint32_t hits = killMask(xs[i], ys[i], kill[i] + extraRange,
+                                             &cellX[block], &cellY[block], n);
+
+                    while (hits) {
+                        uint32_t j = cellEntries[block + lowestBit(hits)];
+                        hits &= hits - 1;
+                        if (j > i) {
+                            out.push_back({static_cast<uint32_t>(i), j});
+                        }
+                    }
+                }
+            }
+        }
+    }
+    counters.candidatesChecked += tested;
+
+    // Тот же порядок, что и у полного перебора
+    std::sort(out.begin(), out.end(), [](const BattlePair& a, const BattlePair& b) {
+        return a.attacker != b.attacker ? a.attacker < b.attacker
+                                        : a.defender < b.defender;
+    });
+}
+
+bool VerletBroadphase::needsRebuild(const World& world, int mapX, int mapY) const {
+    if (world.size() != builtSize || world.generation() != builtGeneration ||
+        mapX != builtMapX || mapY != builtMapY) {
+        return true;
+    }
+
+    // Пара сближается не больше чем на сумму смещений участников
+    const auto& xs = world.xs();
+    const auto& ys = world.ys();
+    const auto& moves = world.moveDistances();
+    for (size_t i = 0; i < builtSize; ++i) {
+        long long dx = xs[i] - refX[i];
+        long long dy = ys[i] - refY[i];
+        long long skin = static_cast<long long>(skinTicks) * moves[i];
+        if (dx * dx + dy * dy > skin * skin && world.isAlive(i)) return true;
+    }
+    return false;
+}
+
+bool VerletBroadphase::rebuild(const World& world, int mapX, int mapY) {
+    const auto& xs = world.xs();
+    const auto& ys = world.ys();
+    const auto& moves = world.moveDistances();
+    const auto& kill = world.killDistances();
+    int maxMove = 0;
+    size_t alive = 0;
+    double radiusSum = 0;
+    for (size_t i = 0; i < world.size(); ++i) {
+        if (!world.isAlive(i)) continue;
+        maxMove = std::max(maxMove, moves[i]);
+        radiusSum += kill[i] + 2.0 * skinTicks * moves[i];
+        alive++;
+    }
+
+    // Ожидаемое число кандидатов при равномерном распределении NPC
+    const double pi = 3.14159265358979;
+    double radius = alive ? radiusSum / alive : 0;
+    double expected = 0.5 * alive * pi * radius * radius * alive /
+                      (static_cast<double>(std::max(mapX, 1)) * std::max(mapY, 1));
+    if (expected > MAX_CANDIDATES_PER_NPC * alive) {
+        builtSize = 0;  // списки недействительны, следующий тик попробует снова
+        return false;
+    }
+
+    // Сетка ищет с запасом skin_i + max skin, затем отсекаем по точному радиусу
+    grid.findPairsWithin(world, mapX, mapY, 2 * skinTicks * maxMove, candidates);
+    size_t kept = 0;
+    for (const BattlePair& c : candidates) {
+        long long dx = static_cast<long long>(xs[c.attacker]) - xs[c.defender];
+        long long dy = static_cast<long long>(ys[c.attacker]) - ys[c.defender];
+        long long r = kill[c.attacker] +
+                      static_cast<long long>(skinTicks) * (moves[c.attacker] + moves[c.defender]);
+        if (dx * dx + dy * dy <= r * r) candidates[kept++] = c;
+    }
+    candidates.resize(kept);
+
+    refX = xs;
+    refY = ys;
+    builtSize = world.size();
+    builtGeneration = world.generation();
+    builtMapX = mapX;
+    builtMapY = mapY;
+
+    counters.rebuilds++;
+    counters.candidates = candidates.size();
+    counters.maxCandidates = std::max(counters.maxCandidates, candidates.size());
+    return true;
+}
+
+void VerletBroadphase::findPairs(const World& world,
+                                 int mapX, int mapY,
+                                 std::vector<BattlePair>& out) {
+    counters.calls++;
+    if (needsRebuild(world, mapX, mapY) && !rebuild(world, mapX, mapY)) {
+        counters.fallbacks++;
+        grid.findPairs(world, mapX, mapY, out);
+        return;
+    }
+    counters.candidatesChecked += candidates.size();
+
+    out.clear();
+    const auto& xs = world.xs();
+    const auto& ys = world.ys();
+    const auto& kill = world.killDistances();
+
+    // Кандидаты уже в порядке полного перебора - сортировать не нужно
+    size_t kept = 0;
+    for (const BattlePair& c : candidates) {
+        if (!world.isAlive(c.attacker) || !world.isAlive(c.defender)) continue;
+        // Мертвые больше не оживают: выбрасываем их из списка
+        candidates[kept++] = c;
+
+        long long dx = static_cast<long long>(xs[c.attacker]) - xs[c.defender];
+        long long dy = static_cast<long long>(ys[c.attacker]) - ys[c.defender];
+        long long k = kill[c.attacker];
+        if (dx * dx + dy * dy <= k * k) out.push_back(c);
+    }
+    candidates.resize(kept);
+}
+
+std::unique_ptr<Broadphase> makeBroadphase(BroadphaseKind kind, size_t shards) {
+    switch (kind) {
+        case BroadphaseKind::BRUTE_FORCE: return std::make_unique<BruteForceBroadphase>();
+        case BroadphaseKind::UNIFORM_GRID: return std::make_unique<UniformGridBroadphase>();
+        case BroadphaseKind::VERLET: return std::make_unique<VerletBroadphase>();
+        case BroadphaseKind::SHARDED: return std::make_unique<ShardedBroadphase>(shards);
+    }
+    return std::make_unique<UniformGridBroadphase>();
+}
@@ -0,0 +1,132 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include "world.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Пара NPC, которые должны сразиться (индексы в World)
+struct BattlePair {
+    uint32_t attacker;
+    uint32_t defender;
+};
+
+// Движок поиска пар для боя
+enum class BroadphaseKind {
+    BRUTE_FORCE,   // полный перебор i < j, O(n^2)
+    UNIFORM_GRID,  // равномерная сетка с ячейкой = max killDistance
+    VERLET,        // списки соседей с запасом, перестройка по смещению
+    SHARDED        // полосы карты по потокам с обменом ореолом (shards.h)
+};
+
+// Счетчики broadphase. candidatesChecked ведут все движки; остальное -
+// только списки соседей и шарды.
+struct BroadphaseStats {
+    uint64_t calls = 0;
+    uint64_t rebuilds = 0;           // перестройки списков / перераспределения шардов
+    uint64_t fallbacks = 0;          // тики без списков (списки были бы слишком велики)
+    uint64_t candidatesChecked = 0;  // проверено кандидатов, сумма по вызовам
+    size_t candidates = 0;           // размер списка после последней перестройки
+    size_t maxCandidates = 0;
+    size_t shards = 0;               // шардов в работе (0 - не шардированный поиск)
+    uint64_t migrations = 0;         // переходов NPC между шардами
+    uint64_t haloEntries = 0;        // сумма размеров ореолов по вызовам
+};
+
+// Базовый класс broadphase: находит все пары живых NPC (i, j), i < j,
+// где j в пределах killDistance от i. Дистанция проверяется векторным
+// ядром killMask. Порядок пар - как у полного перебора.
+class Broadphase {
+public:
+    virtual ~Broadphase() = default;
+
+    virtual void findPairs(const World& world,
+                           int mapX, int mapY,
+                           std::vector<BattlePair>& out) = 0;
+
+    virtual const char* name() const = 0;
+
+    virtual BroadphaseStats stats() const { return {}; }
+};
+
+class BruteForceBroadphase : public Broadphase {
+private:
+    BroadphaseStats counters;
+
+public:
+    void findPairs(const World& world,
+                   int mapX, int mapY,
+                   std::vector<BattlePair>& out) override;
+
+    const char* name() const override { return "brute"; }
+    BroadphaseStats stats() const override { return counters; }
+};
+
+class UniformGridBroadphase : public Broadphase {
+private:
+    // Ячейки хранятся в CSR-виде: cellStart[c]..cellStart[c+1] в cellEntries
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellEntries;
+    std::vector<int> cellX, cellY;  // координаты в порядке cellEntries для ядра
+    std::vector<uint32_t> npcCell;
+    BroadphaseStats counters;
+
+public:
+    void findPairs(const World& world,
+                   int mapX, int mapY,
+                   std::vector<BattlePair>& out) override;
+
+    // Пары в пределах killDistance + extraRange (для списков соседей)
+    void findPairsWithin(const World& world,
+                         int mapX, int mapY, int extraRange,
+                         std::vector<BattlePair>& out);
+
+    const char* name() const override { return "grid"; }
+    BroadphaseStats stats() const override { return counters; }
+};
+
+// Списки соседей Верле. У каждого NPC свой запас skin = skinTicks *
+// moveDistance; кандидаты - пары (i, j) в радиусе kill_i + skin_i +
+// skin_j, их ищет сетка. Каждый тик проверяются только кандидаты. Пока
+// каждый NPC сместился от позиции перестройки не больше своего skin,
+// никакая пара не могла войти в радиус извне списка, поэтому результат
+// совпадает с полным перебором. Иначе - перестройка.
+//
+// Списки выгодны, когда NPC за тик смещаются мало по сравнению с
+// killDistance; при быстрых NPC на плотной карте лучше обычная сетка.
+class VerletBroadphase : public Broadphase {
+private:
+    int skinTicks;
+    UniformGridBroadphase grid;
+    std::vector<BattlePair> candidates;   // по возрастанию (attacker, defender)
+    std::vector<int> refX, refY;          // позиции при перестройке
+    size_t builtSize = 0;
+    uint32_t builtGeneration = 0;  // сжатие мира перенумеровывает NPC
+    int builtMapX = 0, builtMapY = 0;
+    BroadphaseStats counters;
+
+    bool needsRebuild(const World& world, int mapX, int mapY) const;
+    bool rebuild(const World& world, int mapX, int mapY);
+
+public:
+    explicit VerletBroadphase(int skinTicks = DEFAULT_SKIN_TICKS) : skinTicks(skinTicks) {}
+
+    static constexpr int DEFAULT_SKIN_TICKS = 2;
+
+    // Если по оценке на NPC пришлось бы больше кандидатов, тик считается
+    // обычной сеткой: на плотной карте списки дороже самого поиска
+    static constexpr double MAX_CANDIDATES_PER_NPC = 32.0;
+
+    void findPairs(const World& world,
+                   int mapX, int mapY,
+                   std::vector<BattlePair>& out) override;
+
+    const char* name() const override { return "verlet"; }
+    BroadphaseStats stats() const override { return counters; }
+};
+
+// shards - число шардов для SHARDED (0 - по числу ядер)
+std::unique_ptr<Broadphase> makeBroadphase(BroadphaseKind kind, size_t shards = 0);
+
+#endif
@@ -0,0 +1,414 @@
+#include "cluster.h"
+#include "factory.h"
+#include "npc_arena.h"
+#include "world.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+static WireNPC toWire(uint32_t id, const NPC& npc) {
+    WireNPC w;
+    w.id = id;
+    w.x = npc.getX();
+    w.y = npc.getY();
+    w.life = NPCLife::pack(npc.isAlive(), npc.getHealth());
+    w.moveDistance = static_cast<uint16_t>(npc.getMoveDistance());
+    w.killDistance = static_cast<uint16_t>(npc.getKillDistance());
+    w.type = static_cast<uint8_t>(npc.getType());
+    return w;
+}
+
+static bool byId(const WireNPC& a, const WireNPC& b) {
+    return a.id < b.id;
+}
+
+ClusterCoordinator::ClusterCoordinator(const ClusterConfig& config) : config(config) {
+    if (config.shards < 1) throw std::invalid_argument("cluster needs at least one shard");
+    if (config.socketPath.empty()) throw std::invalid_argument("cluster needs a socket path");
+
+    this->config.seed = config.seed != 0 ? config.seed : Rng::randomSeed();
+    Rng::setMasterSeed(this->config.seed);
+
+    NPCArena arena;
+    NPCFactory::createRandomNPCs(arena, config.npcCount, config.mapX, config.mapY);
+    initial.reserve(arena.size());
+    for (const NPC* npc : arena) {
+        initial.push_back(toWire(static_cast<uint32_t>(initial.size()), *npc));
+        halo = std::max(halo, npc->getKillDistance());
+    }
+
+    // Ореол берется только у соседних полос, поэтому полоса не уже halo
+    stripWidth = (config.mapX + config.shards - 1) / config.shards;
+    if (stripWidth < halo) {
+        throw std::invalid_argument("map is too narrow for " + std::to_string(config.shards) +
+                                    " shards: strips must be at least " +
+                                    std::to_string(halo) + " wide");
+    }
+
+    listenFd = listenUnix(config.socketPath, config.shards);
+}
+
+ClusterCoordinator::~ClusterCoordinator() {
+    for (int fd : shardFds) closeSocket(fd);
+    if (listenFd >= 0) {
+        closeSocket(listenFd);
+        std::remove(config.socketPath.c_str());
+    }
+}
+
+int ClusterCoordinator::shardFor(int x) const {
+    return std::min(std::max(x, 0) / stripWidth, config.shards - 1);
+}
+
+void ClusterCoordinator::send(int shard, WireMessage type, uint64_t tick,
+                              const WireWriter& payload, ClusterReport& report) {
+    report.bytesSent += sendFrame(shardFds[shard], type, tick, payload);
+}
+
+void ClusterCoordinator::receive(int shard, WireMessage expected, WireFrame& frame,
+                                 ClusterReport& report) {
+    report.bytesReceived += recvFrame(shardFds[shard], frame);
+    if (frame.type != expected) {
+        throw std::runtime_error("shard " + std::to_string(shard) + " sent message " +
+                                 std::to_string(static_cast<int>(frame.type)) + ", expected " +
+                                 std::to_string(static_cast<int>(expected)));
+    }
+}
+
+ClusterReport ClusterCoordinator::run() {
+    using Clock = std::chrono::steady_clock;
+    const int shards = config.shards;
+    ClusterReport report;
+    report.shards = shards;
+
+    WireFrame frame;
+    shardFds.clear();
+    for (int s = 0; s < shards; ++s) {
+        shardFds.push_back(acceptUnix(listenFd));
+        receive(s, WireMessage::HELLO, frame, report);
+    }
+
+    // Начальная раздача: полоса, параметры тика и свои NPC
+    std::vector<std::vector<WireNPC>> incoming(shards), haloFor(shards);
+    ownerOf.resize(initial.size());
+    for (const WireNPC& npc : initial) {
+        ownerOf[npc.id] = static_cast<uint32_t>(shardFor(npc.x));
+        incoming[ownerOf[npc.id]].push_back(npc);
+    }
+    for (int s = 0; s < shards; ++s) {
+        WireWriter assign;
+        assign.put32(static_cast<uint32_t>(s));
+        assign.put32(static_cast<uint32_t>(shards));
+        assign.put32(static_cast<uint32_t>(s * stripWidth));
+        assign.put32(static_cast<uint32_t>((s + 1) * stripWidth));
+        assign.put32(static_cast<uint32_t>(config.mapX));
+        assign.put32(static_cast<uint32_t>(config.mapY));
+        assign.put32(static_cast<uint32_t>(halo));
+        assign.put64(Rng::streamSeed(Rng::MOVEMENT_STREAM));
+        assign.put64(Rng::streamSeed(Rng::BATTLE_ROUND_STREAM));
+        assign.putNPCs(incoming[s]);
+        send(s, WireMessage::ASSIGN, 0, assign, report);
+    }
+
+    const auto startTime = Clock::now();
+    std::vector<std::vector<uint32_t>> kills(shards);
+    std::vector<WireNPC> migrants, border;
+    std::vector<uint32_t> foreignKills;
+    WireWriter out;
+
+    for (uint64_t tick = 1; tick <= config.ticks; ++tick) {
+        for (int s = 0; s < shards; ++s) {
+            out.clear();
+            out.putIds(kills[s]);
+            kills[s].clear();
+            send(s, WireMessage::STEP, tick, out, report);
+        }
+
+        // Пришедшие уходят новому владельцу; и они, и NPC у границ -
+        // в ореол соседних полос, если лежат не дальше halo от них
+        for (int s = 0; s < shards; ++s) {
+            incoming[s].clear();
+            haloFor[s].clear();
+        }
+        auto toNeighbours = [&](const WireNPC& npc, int owner) {
+            for (int n = std::max(owner - 1, 0); n <= std::min(owner + 1, shards - 1); ++n) {
+                if (n != owner && npc.x >= n * stripWidth - halo &&
+                    npc.x < (n + 1) * stripWidth + halo) {
+                    haloFor[n].push_back(npc);
+                }
+            }
+        };
+        for (int s = 0; s < shards; ++s) {
+            receive(s, WireMessage::EXCHANGE, frame, report);
+            WireReader in(frame.payload);
+            migrants.clear();
+            border.clear();
+            in.getNPCs(migrants);
+            in.getNPCs(border);
+            for (const WireNPC& npc : migrants) {
+                int owner = shardFor(npc.x);
+                ownerOf[npc.id] = static_cast<uint32_t>(owner);
+                incoming[owner].push_back(npc);
+                toNeighbours(npc, owner);
+            }
+            for (const WireNPC& npc : border) toNeighbours(npc, s);
+            report.migrations += migrants.size();
+        }
+
+        for (int s = 0; s < shards; ++s) {
+            out.clear();
+            out.putNPCs(incoming[s]);
+            out.putNPCs(haloFor[s]);
+            report.haloEntries += haloFor[s].size();
+            send(s, WireMessage::HALO, tick, out, report);
+        }
+
+        // Барьер тика: ждем итоги всех шардов
+        for (int s = 0; s < shards; ++s) {
+            receive(s, WireMessage::REPORT, frame, report);
+            WireReader in(frame.payload);
+            report.battlesFought += in.get64();
+            report.staleKills += in.get64();
+            foreignKills.clear();
+            in.getIds(foreignKills);
+            for (uint32_t id : foreignKills) kills[ownerOf[id]].push_back(id);
+            report.crossShardKills += foreignKills.size();
+        }
+        report.ticks++;
+    }
+
+    // STOP несет убийства последнего тика; в ответ - живые NPC шарда
+    for (int s = 0; s < shards; ++s) {
+        out.clear();
+        out.putIds(kills[s]);
+        send(s, WireMessage::STOP, config.ticks, out, report);
+    }
+    for (int s = 0; s < shards; ++s) {
+        receive(s, WireMessage::FINAL, frame, report);
+        WireReader in(frame.payload);
+        report.staleKills += in.get64();
+        migrants.clear();
+        in.getNPCs(migrants);
+        for (const WireNPC& npc : migrants) {
+            report.alive++;
+            if (npc.type < NPC_TYPE_COUNT) report.aliveByType[npc.type]++;
+        }
+    }
+    report.dead = initial.size() - report.alive;
+    report.totalSeconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+    return report;
+}
+
+ClusterShard::ClusterShard(const std::string& socketPath, int connectTimeoutMillis)
+    : fd(connectUnix(socketPath, connectTimeoutMillis)) {}
+
+ClusterShard::~ClusterShard() {
+    closeSocket(fd);
+}
+
+void ClusterShard::run() {
+    WireWriter out;
+    sendFrame(fd, WireMessage::HELLO, 0, out);
+
+    WireFrame frame;
+    recvFrame(fd, frame);
+    if (frame.type != WireMessage::ASSIGN) throw std::runtime_error("shard expected ASSIGN");
+    {
+        WireReader in(frame.payload);
+        index = static_cast<int>(in.get32());
+        shardCount = static_cast<int>(in.get32());
+        x0 = static_cast<int>(in.get32());
+        x1 = static_cast<int>(in.get32());
+        mapX = static_cast<int>(in.get32());
+        mapY = static_cast<int>(in.get32());
+        halo = static_cast<int>(in.get32());
+        moveSeed = in.get64();
+        battleSeed = in.get64();
+        owned.clear();
+        in.getNPCs(owned);
+    }
+
+    const bool hasLow = index > 0;
+    const bool hasHigh = index + 1 < shardCount;
+    std::vector<uint32_t> kills;
+    std::vector<WireNPC> migrants, border, haloNPCs;
+    uint64_t stale = 0;
+
+    for (;;) {
+        recvFrame(fd, frame);
+        WireReader in(frame.payload);
+
+        if (frame.type == WireMessage::STEP) {
+            kills.clear();
+            in.getIds(kills);
+            stale = applyKills(kills);
+            move(frame.tick);
+
+            // Мертвые больше не нужны; ушедшие из полосы - координатору
+            migrants.clear();
+            border.clear();
+            size_t kept = 0;
+            for (const WireNPC& npc : owned) {
+                if (!NPCLife::alive(npc.life)) continue;
+                if ((hasLow && npc.x < x0) || (hasHigh && npc.x >= x1)) {
+                    migrants.push_back(npc);
+                    continue;
+                }
+                if ((hasLow && npc.x < x0 + halo) || (hasHigh && npc.x >= x1 - halo)) {
+                    border.push_back(npc);
+                }
+                owned[kept++] = npc;
+            }
+            owned.resize(kept);
+
+            out.clear();
+            out.putNPCs(migrants);
+            out.putNPCs(border);
+            sendFrame(fd, WireMessage::EXCHANGE, frame.tick, out);
+        } else if (frame.type == WireMessage::HALO) {
+            size_t before = owned.size();
+            in.getNPCs(owned);
+            if (owned.size() != before) std::sort(owned.begin(), owned.end(), byId);
+            haloNPCs.clear();
+            in.getNPCs(haloNPCs);
+
+            out.clear();
+            fight(frame.tick, haloNPCs, out, stale);
+            sendFrame(fd, WireMessage::REPORT, frame.tick, out);
+        } else if (frame.type == WireMessage::STOP) {
+            kills.clear();
+            in.getIds(kills);
+            stale = applyKills(kills);
+
+            migrants.clear();
+            for (const WireNPC& npc : owned) {
+                if (NPCLife::alive(npc.life)) migrants.push_back(npc);
+            }
+            out.clear();
+            out.put64(stale);
+            out.putNPCs(migrants);
+            sendFrame(fd, WireMessage::FINAL, frame.tick, out);
+            return;
+        } else {
+            throw std::runtime_error("shard got unexpected message " +
+                                     std::to_string(static_cast<int>(frame.type)));
+        }
+    }
+}
+
+uint64_t ClusterShard::applyKills(const std::vector<uint32_t>& ids) {
+    uint64_t stale = 0;
+    for (uint32_t id : ids) {
+        WireNPC key;
+        key.id = id;
+        auto it = std::lower_bound(owned.begin(), owned.end(), key, byId);
+        if (it == owned.end() || it->id != id || !NPCLife::alive(it->life)) {
+            stale++;  // погиб в своем шарде раньше, чем дошло убийство
+            continue;
+        }
+        it->life = NPCLife::pack(false, 0);
+    }
+    return stale;
+}
+
+// Шаг NPC - от (сида, тика, номера NPC): не зависит от того, чей он
+void ClusterShard::move(uint64_t tick) {
+    const uint64_t tickSeed = moveSeed ^ splitmix64(tick);
+    for (WireNPC& npc : owned) {
+        if (!NPCLife::alive(npc.life)) continue;
+        Xoshiro256 gen(tickSeed ^ splitmix64(npc.id + 1ull));
+        int x = npc.x, y = npc.y;
+        NPC::step(x, y, npc.moveDistance, mapX, mapY, gen);
+        npc.x = x;
+        npc.y = y;
+    }
+}
+
+// Бои полосы: свои NPC и ореол в одном мире по возрастанию id, тогда
+// пара (i, j), i < j, мира - это пара (id_i, id_j) полного перебора
+void ClusterShard::fight(uint64_t tick, std::vector<WireNPC>& haloNPCs,
+                         WireWriter& report, uint64_t stale) {
+    struct LocalNPC {
+        WireNPC* npc;
+        bool owned;
+    };
+    std::vector<LocalNPC> local;
+    local.reserve(owned.size() + haloNPCs.size());
+    for (WireNPC& npc : owned) {
+        if (NPCLife::alive(npc.life)) local.push_back({&npc, true});
+    }
+    for (WireNPC& npc : haloNPCs) local.push_back({&npc, false});
+    std::sort(local.begin(), local.end(), [](const LocalNPC& a, const LocalNPC& b) {
+        return a.npc->id < b.npc->id;
+    });
+
+    // Координаты сдвинуты к началу полосы с ореолом: сетке нужна только она
+    const int originX = x0 - halo;
+    std::vector<int> xs(local.size()), ys(local.size()), health(local.size());
+    std::vector<uint8_t> alive(local.size(), 1);
+    NPCStatics statics;
+    statics.nameIds.assign(local.size(), 0);
+    for (size_t k = 0; k < local.size(); ++k) {
+        const WireNPC& npc = *local[k].npc;
+        xs[k] = npc.x - originX;
+        ys[k] = npc.y;
+        health[k] = NPCLife::health(npc.life);
+        statics.type.push_back(static_cast<NPCType>(npc.type));
+        statics.moveDistance.push_back(npc.moveDistance);
+        statics.killDistance.push_back(npc.killDistance);
+    }
+    World world = World::fromColumns(std::move(xs), std::move(ys), std::move(alive),
+                                     std::move(health), std::move(statics));
+    grid.findPairs(world, x1 - x0 + 2 * halo, mapY, pairs);
+
+    uint64_t fought = 0;
+    std::vector<uint32_t> foreignKills;
+    const uint64_t tickSeed = battleSeed ^ splitmix64(tick);
+    for (const BattlePair& p : pairs) {
+        if (!local[p.attacker].owned) continue;  // бой ведет шард атакующего
+        const uint64_t key = uint64_t{local[p.attacker].npc->id} << 32 | local[p.defender].npc->id;
+        const bool attackerWins = attackerWinsDice(tickSeed ^ splitmix64(key));
+        // То же правило боя, что в Game: бой с мертвым не состоится
+        world.tryFight(world.handle(p.attacker), world.handle(p.defender), attackerWins,
+                       [&](NPCHandle loser) {
+            fought++;
+            if (!local[loser.index].owned) foreignKills.push_back(local[loser.index].npc->id);
+        });
+    }
+
+    for (size_t k = 0; k < local.size(); ++k) {
+        if (local[k].owned) local[k].npc->life = world.lifeWord(k);
+    }
+
+    report.put64(fought);
+    report.put64(stale);
+    report.putIds(foreignKills);
+}
+
+void printClusterReport(const ClusterReport& report) {
+    const std::streamsize oldPrecision = std::cout.precision();
+    std::cout << "\n=== CLUSTER REPORT ===\n";
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Shards: " << report.shards << ", ticks: " << report.ticks << " in "
+              << report.totalSeconds << " s (" << std::setprecision(1)
+              << report.ticksPerSecond() << " ticks/s)\n";
+    std::cout << "Battles: " << report.battlesFought << " fought, "
+              << report.crossShardKills << " cross-shard kills ("
+              << report.staleKills << " stale)\n";
+    std::cout << "Exchange: " << report.migrations << " migrations, "
+              << report.haloEntries << " halo NPCs, "
+              << report.bytesSent << " bytes sent, "
+              << report.bytesReceived << " bytes received\n";
+    std::cout << "Alive: " << report.alive << ", dead: " << report.dead << "\n";
+    for (size_t t = 0; t < NPC_TYPE_COUNT; ++t) {
+        if (report.aliveByType[t] > 0) {
+            std::cout << "  " << NPC::typeToString(static_cast<NPCType>(t))
+                      << ": " << report.aliveByType[t] << "\n";
+        }
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout.precision(oldPrecision);
+}
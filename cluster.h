@@ -0,0 +1,126 @@
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include "npc.h"
+#include "broadphase.h"
+#include "wire.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Игра несколькими процессами. Карта делится по x на полосы, каждой
+// владеет процесс-шард (ClusterShard). Координатор (ClusterCoordinator)
+// создает мир, раздает NPC по полосам и ведет тики общими барьерами.
+// Все сообщения идут через координатора по Unix-сокетам (wire.h).
+//
+// Тик - два обмена:
+//   STEP     -> шард применяет убийства своих NPC чужими боями прошлого
+//               тика и двигает своих NPC;
+//   EXCHANGE <- ушедшие из полосы и NPC не дальше halo от границ;
+//   HALO     -> шард забирает пришедших, получает ореол соседей и
+//               разрешает бои, где атакующий - его NPC;
+//   REPORT   <- итоги тика и убийства NPC других шардов.
+// Шаги и кубики берутся от номера NPC и тика, а не от шарда, поэтому
+// прогон зависит только от сида и числа шардов. Бои внутри полосы идут
+// как в одном процессе; убийство NPC соседа применяется на следующем
+// тике, и до этого он еще может победить в своем шарде.
+//
+// Кластер - отдельная модель игры, а не тик Game, разрезанный по
+// процессам. С Game общие World, сеточный broadphase и правило боя
+// World::tryFight, но шаги NPC берутся из своего потока случайных
+// чисел, бои полосы идут одним проходом по парам, а пула боев, сжатия,
+// журналов и метрик нет. Итоги при том же сиде не совпадают с
+// Game::runHeadless и с ним не сравниваются.
+
+struct ClusterConfig {
+    int shards = 2;
+    int npcCount = 50;
+    int mapX = 100;
+    int mapY = 100;
+    uint64_t seed = 0;  // 0 - случайный сид
+    uint64_t ticks = 100;
+    std::string socketPath;
+};
+
+// Итоги кластера: счетчики шардов, сложенные координатором
+struct ClusterReport {
+    int shards = 0;
+    uint64_t ticks = 0;
+    double totalSeconds = 0;
+    uint64_t battlesFought = 0;
+    uint64_t crossShardKills = 0;  // убийства NPC другого шарда
+    uint64_t staleKills = 0;       // такой NPC уже погиб у владельца
+    uint64_t migrations = 0;
+    uint64_t haloEntries = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    size_t alive = 0;
+    size_t dead = 0;
+    std::array<size_t, NPC_TYPE_COUNT> aliveByType{};
+
+    double ticksPerSecond() const { return totalSeconds > 0 ? ticks / totalSeconds : 0; }
+};
+
+class ClusterCoordinator {
+public:
+    // Создает мир и начинает слушать сокет: шарды можно запускать сразу
+    explicit ClusterCoordinator(const ClusterConfig& config);
+    ~ClusterCoordinator();
+
+    ClusterCoordinator(const ClusterCoordinator&) = delete;
+    ClusterCoordinator& operator=(const ClusterCoordinator&) = delete;
+
+    // Ждет config.shards шардов, гоняет тики и собирает итоги
+    ClusterReport run();
+
+    uint64_t seed() const { return config.seed; }
+
+private:
+    ClusterConfig config;
+    int listenFd = -1;
+    std::vector<int> shardFds;
+    std::vector<WireNPC> initial;
+    std::vector<uint32_t> ownerOf;  // шард-владелец каждого NPC
+    int stripWidth = 1;
+    int halo = 1;
+
+    int shardFor(int x) const;
+    void send(int shard, WireMessage type, uint64_t tick, const WireWriter& payload,
+              ClusterReport& report);
+    void receive(int shard, WireMessage expected, WireFrame& frame, ClusterReport& report);
+};
+
+class ClusterShard {
+public:
+    explicit ClusterShard(const std::string& socketPath, int connectTimeoutMillis = 5000);
+    ~ClusterShard();
+
+    ClusterShard(const ClusterShard&) = delete;
+    ClusterShard& operator=(const ClusterShard&) = delete;
+
+    // Исполняет тики до STOP
+    void run();
+
+private:
+    int fd = -1;
+    int index = 0;
+    int shardCount = 1;
+    int x0 = 0, x1 = 0;  // полоса [x0, x1)
+    int mapX = 0, mapY = 0;
+    int halo = 1;
+    uint64_t moveSeed = 0;
+    uint64_t battleSeed = 0;
+    std::vector<WireNPC> owned;  // по возрастанию id
+    UniformGridBroadphase grid;
+    std::vector<BattlePair> pairs;
+
+    // Убивает своих NPC по номерам; возвращает, сколько уже были мертвы
+    uint64_t applyKills(const std::vector<uint32_t>& ids);
+    void move(uint64_t tick);
+    void fight(uint64_t tick, std::vector<WireNPC>& haloNPCs, WireWriter& report, uint64_t stale);
+};
+
+void printClusterReport(const ClusterReport& report);
+
+#endif
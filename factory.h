@@ -2,35 +2,44 @@
 #define FACTORY_H
 
 #include "npc.h"
+#include "rng.h"
+#include "npc_arena.h"
 #include <memory>
-#include <random>
 #include <vector>
 #include <string>
 
 class NPCFactory {
 private:
     static std::string generateName(NPCType type, int index) {
-        std::string baseName;
-        switch(type) {
-            case NPCType::ORC: baseName = "Orc"; break;
-            case NPCType::SQUIRREL: baseName = "Squirrel"; break;
-            case NPCType::DRUID: baseName = "Druid"; break;
-            case NPCType::KNIGHT: baseName = "Knight"; break;
-            case NPCType::ELF: baseName = "Elf"; break;
-            case NPCType::DRAGON: baseName = "Dragon"; break;
-            case NPCType::BEAR: baseName = "Bear"; break;
-            case NPCType::BANDIT: baseName = "Bandit"; break;
-            case NPCType::WEREWOLF: baseName = "Werewolf"; break;
-            case NPCType::PRINCESS: baseName = "Princess"; break;
-            case NPCType::TOAD: baseName = "Toad"; break;
-            case NPCType::SLAVER: baseName = "Slaver"; break;
-            case NPCType::PEGASUS: baseName = "Pegasus"; break;
-            case NPCType::BITTERN: baseName = "Bittern"; break;
-            case NPCType::DESMAN: baseName = "Desman"; break;
-            case NPCType::BULL: baseName = "Bull"; break;
-            default: baseName = "Unknown"; break;
+        std::string name = traitsOf(type).name;
+        name += '_';
+        name += std::to_string(index);
+        return name;
+    }
+    
+    // Общий цикл случайной популяции: spawn(type, name, x, y) на каждого NPC
+    template <typename Spawn>
+    static void spawnRandom(int count, int maxX, int maxY, Spawn&& spawn) {
+        // Отдельный поток случайности: при одном сиде - одна и та же популяция
+        Xoshiro256 gen = Rng::stream(Rng::SPAWN_STREAM);
+        
+        static const NPCType allTypes[] = {
+            NPCType::ORC, NPCType::SQUIRREL, NPCType::DRUID,
+            NPCType::KNIGHT, NPCType::ELF, NPCType::DRAGON,
+            NPCType::BEAR, NPCType::BANDIT, NPCType::WEREWOLF,
+            NPCType::PRINCESS, NPCType::TOAD, NPCType::SLAVER,
+            NPCType::PEGASUS, NPCType::BITTERN, NPCType::DESMAN,
+            NPCType::BULL
+        };
+        
+        for (int i = 0; i < count; ++i) {
+            NPCType type = allTypes[gen.uniform(0, 15)];
+            std::string name = generateName(type, i + 1);
+            int x = gen.uniform(0, maxX - 1);
+            int y = gen.uniform(0, maxY - 1);
+            
+            spawn(type, name, x, y);
         }
-        return baseName + "_" + std::to_string(index);
     }
     
 public:
@@ -58,36 +67,51 @@ public:
         }
     }
     
+    static NPC* createNPC(NPCArena& arena, NPCType type,
+                          const std::string& name, int x, int y) {
+        switch(type) {
+            case NPCType::ORC: return arena.create<Orc>(name, x, y);
+            case NPCType::SQUIRREL: return arena.create<Squirrel>(name, x, y);
+            case NPCType::DRUID: return arena.create<Druid>(name, x, y);
+            case NPCType::KNIGHT: return arena.create<Knight>(name, x, y);
+            case NPCType::ELF: return arena.create<Elf>(name, x, y);
+            case NPCType::DRAGON: return arena.create<Dragon>(name, x, y);
+            case NPCType::BEAR: return arena.create<Bear>(name, x, y);
+            case NPCType::BANDIT: return arena.create<Bandit>(name, x, y);
+            case NPCType::WEREWOLF: return arena.create<Werewolf>(name, x, y);
+            case NPCType::PRINCESS: return arena.create<Princess>(name, x, y);
+            case NPCType::TOAD: return arena.create<Toad>(name, x, y);
+            case NPCType::SLAVER: return arena.create<Slaver>(name, x, y);
+            case NPCType::PEGASUS: return arena.create<Pegasus>(name, x, y);
+            case NPCType::BITTERN: return arena.create<Bittern>(name, x, y);
+            case NPCType::DESMAN: return arena.create<Desman>(name, x, y);
+            case NPCType::BULL: return arena.create<Bull>(name, x, y);
+            default: return nullptr;
+        }
+    }
+    
     static std::vector<std::unique_ptr<NPC>> createRandomNPCs(int count, 
                                                               int maxX, 
                                                               int maxY) {
         std::vector<std::unique_ptr<NPC>> npcs;
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> typeDist(0, 15);
-        std::uniform_int_distribution<> xDist(0, maxX - 1);
-        std::uniform_int_distribution<> yDist(0, maxY - 1);
+        npcs.reserve(count > 0 ? static_cast<size_t>(count) : 0);
         
-        std::vector<NPCType> allTypes = {
-            NPCType::ORC, NPCType::SQUIRREL, NPCType::DRUID,
-            NPCType::KNIGHT, NPCType::ELF, NPCType::DRAGON,
-            NPCType::BEAR, NPCType::BANDIT, NPCType::WEREWOLF,
-            NPCType::PRINCESS, NPCType::TOAD, NPCType::SLAVER,
-            NPCType::PEGASUS, NPCType::BITTERN, NPCType::DESMAN,
-            NPCType::BULL
-        };
-        
-        for (int i = 0; i < count; ++i) {
-            NPCType type = allTypes[typeDist(gen)];
-            std::string name = generateName(type, i + 1);
-            int x = xDist(gen);
-            int y = yDist(gen);
-            
+        spawnRandom(count, maxX, maxY, [&npcs](NPCType type, const std::string& name, int x, int y) {
             npcs.push_back(createNPC(type, name, x, y));
-        }
+        });
         
         return npcs;
     }
+    
+    // То же в арену: вся популяция одним проходом, без malloc на NPC.
+    // При одном сиде популяция совпадает с версией на unique_ptr.
+    static void createRandomNPCs(NPCArena& arena, int count, int maxX, int maxY) {
+        arena.reserve(count > 0 ? static_cast<size_t>(count) : 0);
+        
+        spawnRandom(count, maxX, maxY, [&arena](NPCType type, const std::string& name, int x, int y) {
+            createNPC(arena, type, name, x, y);
+        });
+    }
 };
 
 #endif
\ No newline at end of file
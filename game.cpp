@@ -1,19 +1,90 @@
 #include "game.h"
+#include "kill_kernel.h"
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 
-Game::Game() {
-    // Создаем 50 NPC в случайных локациях
-    auto newNPCs = NPCFactory::createRandomNPCs(50, mapX, mapY);
+Game::Game() : Game(GameConfig{}) {}
+
+Game::Game(const GameConfig& config)
+    : config(config),
+      broadphase(makeBroadphase(config.broadphase,
+                                static_cast<size_t>(std::max(config.shards, 0)))),
+      mapRenderer(config.viewCols, config.viewRows, config.mapStyle) {
+    mapX = config.mapX;
+    mapY = config.mapY;
+    
+    // Все случайные потоки выводятся из одного сида
+    this->config.seed = config.seed != 0 ? config.seed : Rng::randomSeed();
+    Rng::setMasterSeed(this->config.seed);
+    
+    size_t moveThreads = config.movementThreads > 0
+        ? static_cast<size_t>(config.movementThreads)
+        : std::max(1u, std::thread::hardware_concurrency());
+    movementPool = std::make_unique<ThreadPool>(moveThreads);
     
     std::unique_lock<std::shared_mutex> lock(npcsMutex);
-    for (auto& npc : newNPCs) {
-        npcs.push_back(std::move(npc));
+    if (!config.replayPath.empty()) {
+        if (!config.journalPath.empty()) {
+            throw std::invalid_argument("cannot record a journal while replaying one");
+        }
+        // Мир из журнала: индексы должны совпадать с id, поэтому без
+        // сжатия; бои не ищутся и пул не нужен
+        replay = std::make_unique<JournalReader>(config.replayPath);
+        const JournalInfo& info = replay->info();
+        const uint64_t from = std::max(config.replayFrom, replay->firstTick());
+        world = replay->seek(from);
+        tickCount = from;
+        mapX = info.mapX;
+        mapY = info.mapY;
+        this->config.mapX = info.mapX;
+        this->config.mapY = info.mapY;
+        this->config.npcCount = static_cast<int>(world.size());
+        this->config.seed = info.seed;
+        this->config.compactDeadRatio = 0;
+        this->config.battleScheduler = BattleScheduler::ROUNDS;
+    } else if (!config.loadPath.empty()) {
+        // Мир из снимка: карта и номер тика берутся из файла
+        LoadedWorld loaded = WorldFile(config.loadPath).load();
+        world = std::move(loaded.world);
+        tickCount = loaded.tick;
+        mapX = loaded.mapX;
+        mapY = loaded.mapY;
+        this->config.mapX = loaded.mapX;
+        this->config.mapY = loaded.mapY;
+        this->config.npcCount = static_cast<int>(world.size());
+    } else {
+        // Создаем NPC в случайных локациях; арена освобождается целиком
+        NPCArena arena;
+        NPCFactory::createRandomNPCs(arena, config.npcCount, mapX, mapY);
+        world.reserve(arena.size());
+        for (const NPC* npc : arena) {
+            world.add(*npc);
+        }
+    }
+    npcTotal = world.size();
+    for (size_t i = 0; i < world.size(); ++i) {
+        if (world.isAlive(i)) {
+            aliveCounts[static_cast<size_t>(world.getType(world.handle(i)))]++;
+        } else {
+            initialDead++;
+        }
+    }
+    snapshots.publish(world, tickCount, mapX, mapY);
+    battleLog = std::make_unique<BattleLog>(config.battleLog, config.battleLogPath,
+                                            world.sharedStatics(), &coutMutex);
+    if (!config.journalPath.empty()) {
+        journal = std::make_unique<JournalWriter>(config.journalPath, world, tickCount, mapX, mapY,
+                                                  this->config.seed, config.keyframeTicks);
     }
     
     std::lock_guard<std::mutex> coutLock(coutMutex);
-    std::cout << "Created 50 NPCs on " << mapX << "x" << mapY << " map\n";
+    std::cout << (replay ? "Replaying " : config.loadPath.empty() ? "Created " : "Loaded ")
+              << this->config.npcCount << " NPCs on " << mapX << "x" << mapY
+              << " map (broadphase: " << broadphase->name()
+              << ", kernel: " << simdLevelName(activeKillKernel())
+              << ", seed: " << this->config.seed << ")\n";
 }
 
 Game::~Game() {
@@ -23,18 +94,23 @@ Game::~Game() {
 void Game::start() {
     running = true;
     
+    // Снимки с картой для displayWorker. Главный поток пишет метрики
+    // под своей ролью, чтобы не считаться вторым потоком движения.
+    snapshots.setGrid(config.viewCols, config.viewRows);
+    publishSnapshot(metrics.local("main"));
+    
     // Запускаем потоки
+    startBattlePool();
+    startMetricsExport();
     movementThread = std::thread(&Game::movementWorker, this);
-    battleThread = std::thread(&Game::battleWorker, this);
     displayThread = std::thread(&Game::displayWorker, this);
     
     {
         std::lock_guard<std::mutex> coutLock(coutMutex);
-        std::cout << "Game started! Running for 30 seconds...\n";
+        std::cout << "Game started! Running for " << config.durationSeconds << " seconds...\n";
     }
     
-    // Ждем 30 секунд
-    std::this_thread::sleep_for(std::chrono::seconds(30));
+    std::this_thread::sleep_for(std::chrono::seconds(config.durationSeconds));
     
     stop();
     printSurvivors();
@@ -42,153 +118,459 @@ void Game::start() {
 
 void Game::stop() {
     running = false;
-    battleCV.notify_all();
     
     if (movementThread.joinable()) movementThread.join();
-    if (battleThread.joinable()) battleThread.join();
+    if (battlePool) battlePool->stop();
     if (displayThread.joinable()) displayThread.join();
+    if (battleLog) battleLog->flush();
+    if (journal) journal->flush();
+    
+    // Итоговый снимок с результатами последних боев
+    publishSnapshot(metrics.local("main"));
+    stopMetricsExport();
 }
 
-void Game::movementWorker() {
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        
-        std::shared_lock<std::shared_mutex> readLock(npcsMutex);
-        std::vector<std::shared_ptr<NPC>> currentNPCs = npcs;
-        readLock.unlock();
-        
-        // Перемещаем живых NPC
-        for (auto& npc : currentNPCs) {
-            if (npc->isAlive()) {
-                npc->move(mapX, mapY);
-            }
-        }
-        
-        // Проверяем дистанции для боя
-        std::unique_lock<std::shared_mutex> writeLock(npcsMutex);
-        for (size_t i = 0; i < npcs.size() && running; ++i) {
-            if (!npcs[i]->isAlive()) continue;
-            
-            for (size_t j = i + 1; j < npcs.size(); ++j) {
-                if (!npcs[j]->isAlive()) continue;
-                
-                if (npcs[i]->canKill(*npcs[j])) {
-                    BattleTask task{npcs[i], npcs[j]};
-                    
-                    std::lock_guard<std::mutex> queueLock(battleQueueMutex);
-                    battleQueue.push(task);
-                    battleCV.notify_one();
-                }
+uint64_t Game::saveSnapshot(const std::string& path) const {
+    std::shared_ptr<const WorldSnapshot> snap = snapshots.acquire();
+    WorldFile::save(path, *snap);
+    return snap->tick;
+}
+
+void Game::publishSnapshot(ThreadMetrics& m) {
+    auto readLock = timedLock<std::shared_lock<std::shared_mutex>>(
+        npcsMutex, m, HistogramId::NPCS_LOCK_WAIT);
+    snapshots.publish(world, tickCount, mapX, mapY);
+}
+
+void Game::startBattlePool() {
+    if (config.battleScheduler != BattleScheduler::POOL) return;
+    battlePool = std::make_unique<BattlePool>(
+        static_cast<size_t>(config.battleWorkers), config.battleQueueCapacity,
+        [this](const BattleTask& task) { resolveBattle(task); });
+}
+
+void Game::startMetricsExport() {
+    if (config.metricsPath.empty() || metricsExporter) return;
+    metricsExporter = std::make_unique<MetricsExporter>(metrics, config.metricsPath,
+                                                        config.metricsFormat, config.metricsMillis);
+}
+
+// Выгрузка с финальной записью; следующий start() начнет новую
+void Game::stopMetricsExport() {
+    metricsExporter.reset();
+}
+
+// Сжатие на границе тика: мертвые удаляются, живые сдвигаются и
+// получают новые индексы. Потоки боев на это время приостановлены;
+// задачи, оставшиеся в очереди, несут дескрипторы прошлого поколения
+// и будут отброшены, а отметки их пар снимаются здесь же.
+void Game::compactPhase(ThreadMetrics& m) {
+    if (config.compactDeadRatio <= 0) return;
+    const size_t dead = initialDead + battlesFought.load(std::memory_order_relaxed) - world.removed();
+    if (dead == 0 || dead < config.compactDeadRatio * world.size()) return;
+    
+    if (battlePool) battlePool->pause();
+    {
+        auto writeLock = timedLock<std::unique_lock<std::shared_mutex>>(
+            npcsMutex, m, HistogramId::NPCS_LOCK_WAIT);
+        world.compact();
+        pendingPairs.clear();
+    }
+    if (battlePool) battlePool->resume();
+    compactionCount++;
+}
+
+// Тик из журнала: сдвиги и исходы боев применяются как записаны,
+// кубики не бросаются и пары не ищутся. false - журнал кончился.
+bool Game::replayPhase() {
+    ThreadMetrics& m = metrics.local("movement");
+    ScopedTimer timer(m, HistogramId::MOVE);
+    if (!replay->next(replayStep)) return false;
+    {
+        auto writeLock = timedLock<std::unique_lock<std::shared_mutex>>(
+            npcsMutex, m, HistogramId::NPCS_LOCK_WAIT);
+        JournalReader::applyMoves(world, replayStep);
+        tickCount = replayStep.tick;
+    }
+    for (const BattleRecord& rec : replayStep.battles) {
+        resolveKill(world.handle(rec.attacker), world.handle(rec.defender), rec.attackerWins != 0);
+    }
+    m.add(CounterId::BATTLES_RESOLVED, replayStep.battles.size());
+    publishSnapshot(m);
+    return true;
+}
+
+// Считаем новые позиции в задний буфер мира. Блокировка не нужна:
+// текущие позиции меняет только этот поток, а задний буфер никто не читает.
+void Game::movePhase() {
+    ScopedTimer timer(metrics.local("movement"), HistogramId::MOVE);
+    const uint64_t tickSeed = Rng::streamSeed(Rng::MOVEMENT_STREAM) ^ splitmix64(tickCount++);
+    const int maxX = mapX;
+    const int maxY = mapY;
+    
+    movementPool->parallelFor(world.size(), MOVE_CHUNK, [&](size_t begin, size_t end) {
+        Xoshiro256 gen(tickSeed ^ splitmix64(begin / MOVE_CHUNK + 1));
+        world.computeMoves(begin, end, maxX, maxY, gen);
+    });
+}
+
+// Делаем новые позиции текущими одним обменом
+void Game::publishPhase() {
+    auto writeLock = timedLock<std::unique_lock<std::shared_mutex>>(
+        npcsMutex, metrics.local("movement"), HistogramId::NPCS_LOCK_WAIT);
+    world.publishPositions();
+}
+
+// Проверяем дистанции для боя и собираем бои тика; в режиме POOL здесь
+// же публикуется снимок тика (до боев, они идут в пуле)
+void Game::detectPhase() {
+    ThreadMetrics& m = metrics.local("movement");
+    ScopedTimer timer(m, HistogramId::DETECT);
+    auto readLock = timedLock<std::shared_lock<std::shared_mutex>>(
+        npcsMutex, m, HistogramId::NPCS_LOCK_WAIT);
+    
+    const uint64_t testedBefore = broadphase->stats().candidatesChecked;
+    broadphase->findPairs(world, mapX, mapY, battlePairs);
+    m.add(CounterId::PAIRS_TESTED, broadphase->stats().candidatesChecked - testedBefore);
+    m.add(CounterId::PAIRS_FOUND, battlePairs.size());
+    
+    if (config.battleScheduler == BattleScheduler::ROUNDS) {
+        roundPlanner.plan(battlePairs, world.size());
+    } else {
+        battleBatch.clear();
+        for (const auto& pair : battlePairs) {
+            if (pendingPairs.tryAcquire(pair.attacker, pair.defender)) {
+                battleBatch.push_back({world.handle(pair.attacker), world.handle(pair.defender)});
             }
         }
+        // Бои пула идут после тика, снимок ждать их не может
+        snapshots.publish(world, tickCount, mapX, mapY);
     }
 }
 
-void Game::battleWorker() {
+void Game::movementWorker() {
+    ThreadMetrics& m = metrics.local("movement");
     while (running) {
-        BattleTask task;
+        std::this_thread::sleep_for(std::chrono::milliseconds(config.tickMillis));
         
-        {
-            std::unique_lock<std::mutex> lock(battleQueueMutex);
-            battleCV.wait(lock, [this]() { 
-                return !battleQueue.empty() || !running; 
-            });
-            
-            if (!running && battleQueue.empty()) break;
-            
-            if (!battleQueue.empty()) {
-                task = battleQueue.front();
-                battleQueue.pop();
-            }
+        ScopedTimer tickTimer(m, HistogramId::TICK);
+        if (replay) {
+            if (replayPhase()) m.add(CounterId::TICKS);
+            continue;
         }
+        compactPhase(m);
+        movePhase();
+        publishPhase();
+        detectPhase();
         
-        if (task.attacker && task.defender) {
-            // Проверяем, что NPC еще живы
-            if (!task.attacker->isAlive() || !task.defender->isAlive()) {
-                continue;
-            }
-            
-            // Кидаем кубики
-            bool attackerWins = rollDice();
-            
-            {
-                std::lock_guard<std::mutex> coutLock(coutMutex);
-                std::cout << "BATTLE: " << task.attacker->getName() 
-                          << " vs " << task.defender->getName();
-                std::cout << " -> " << (attackerWins ? task.attacker->getName() 
-                                                    : task.defender->getName())
-                          << " wins!\n";
-            }
-            
-            if (attackerWins) {
-                task.defender->kill();
+        // Бои тика: раунды здесь же или пачка в пул без блокировки мира
+        if (running) {
+            ScopedTimer battleTimer(m, HistogramId::BATTLES);
+            if (config.battleScheduler == BattleScheduler::ROUNDS) {
+                resolveRounds();
             } else {
-                task.attacker->kill();
+                submitBattles();
             }
         }
+        // Тик записывается, даже если игра останавливается: NPC уже сдвинуты.
+        // В режиме ROUNDS снимок - граница тика, вместе с его боями.
+        if (config.battleScheduler == BattleScheduler::ROUNDS) publishSnapshot(m);
+        if (journal) journal->recordTick(world, tickCount);
+        m.add(CounterId::TICKS);
     }
 }
 
+// Раунды идут по очереди, бои внутри раунда - параллельно. Кубики
+// берутся от (сида, тика, номера пары), поэтому итог не зависит ни от
+// числа потоков, ни от того, какой поток взял бой.
+size_t Game::resolveRounds() {
+    const uint64_t tick = tickCount.load(std::memory_order_relaxed);
+    const uint64_t roundSeed = Rng::streamSeed(Rng::BATTLE_ROUND_STREAM) ^ splitmix64(tick);
+    
+    for (size_t r = 0; r < roundPlanner.roundCount(); ++r) {
+        const PlannedBattle* round = roundPlanner.roundBegin(r);
+        movementPool->parallelFor(roundPlanner.roundSize(r), ROUND_GRAIN,
+                                  [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const PlannedBattle& battle = round[i];
+                fightBattle(world.handle(battle.pair.attacker), world.handle(battle.pair.defender),
+                            rollDice(roundSeed ^ splitmix64(battle.index)));
+            }
+        });
+    }
+    battleRoundCount += roundPlanner.roundCount();
+    
+    ThreadMetrics& m = metrics.local("movement");
+    m.add(CounterId::BATTLES_ENQUEUED, roundPlanner.battleCount());
+    m.add(CounterId::BATTLES_RESOLVED, roundPlanner.battleCount());
+    return roundPlanner.battleCount();
+}
+
+size_t Game::submitBattles() {
+    size_t accepted = battlePool->submitBatch(battleBatch);
+    // Пары, которые не поместились в очередь, снова можно ставить
+    for (size_t i = accepted; i < battleBatch.size(); ++i) {
+        pendingPairs.release(battleBatch[i].attacker.index, battleBatch[i].defender.index);
+    }
+    
+    ThreadMetrics& m = metrics.local("movement");
+    m.add(CounterId::BATTLES_ENQUEUED, accepted);
+    m.record(HistogramId::QUEUE_DEPTH, battlePool->queued());
+    return accepted;
+}
+
+void Game::resolveBattle(const BattleTask& task) {
+    if (!task.attacker.valid() || !task.defender.valid()) return;
+    ThreadMetrics& m = metrics.local("battle");
+    
+    // Задача старше сжатия: индексы уже указывают на других NPC
+    if (!world.current(task.attacker) || !world.current(task.defender)) {
+        battlesStale++;
+        return;
+    }
+    {
+        ScopedTimer timer(m, HistogramId::BATTLE);
+        fightBattle(task);
+    }
+    m.add(CounterId::BATTLES_RESOLVED);
+    pendingPairs.release(task.attacker.index, task.defender.index);
+}
+
+void Game::fightBattle(const BattleTask& task) {
+    // Проверка до броска: мертвые не тратят кубики
+    if (!world.isAlive(task.attacker) || !world.isAlive(task.defender)) {
+        return;
+    }
+    fightBattle(task.attacker, task.defender, rollDice());
+}
+
+void Game::fightBattle(NPCHandle attacker, NPCHandle defender, bool attackerWins) {
+    // Мьютексы не нужны: оба участника захватываются в своих словах
+    // жизни (World::tryFight). Проверка до захвата - дешевый отсев боев
+    // с мертвыми.
+    if (!world.isAlive(attacker) || !world.isAlive(defender)) {
+        return;
+    }
+    resolveKill(attacker, defender, attackerWins);
+}
+
+// Убивает проигравшего и учитывает бой. false - один из участников уже
+// погиб в другом бою, и этот бой не засчитывается.
+bool Game::resolveKill(NPCHandle attacker, NPCHandle defender, bool attackerWins) {
+    return world.tryFight(attacker, defender, attackerWins, [&](NPCHandle loser) {
+        aliveCounts[static_cast<size_t>(world.getType(loser))].fetch_sub(1, std::memory_order_relaxed);
+        battlesFought++;
+        
+        // Пока оба захвачены: журнал событий получает бои в порядке смертей
+        const BattleRecord rec{static_cast<uint32_t>(tickCount.load(std::memory_order_relaxed)),
+                               world.stableId(attacker), world.stableId(defender),
+                               attackerWins ? 1u : 0u};
+        battleLog->record(rec);
+        if (journal) journal->recordBattle(rec);
+    });
+}
+
 void Game::displayWorker() {
     while (running) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(config.displayMillis));
         printMap();
     }
 }
 
+MapStatus Game::liveStatus() const {
+    MapStatus status;
+    for (size_t t = 0; t < NPC_TYPE_COUNT; ++t) {
+        status.aliveByType[t] = aliveCounts[t].load(std::memory_order_relaxed);
+        status.alive += status.aliveByType[t];
+    }
+    status.dead = npcTotal - status.alive;
+    status.battles = battlesFought;
+    status.tick = tickCount;
+    return status;
+}
+
 void Game::printMap() const {
+    // Работаем со снимком: мир не блокируется, пока идет вывод.
+    // Кадр строится по карте снимка и счетчикам - без прохода по NPC.
+    std::shared_ptr<const WorldSnapshot> snap = snapshots.acquire();
+    if (!snap) return;
+    ThreadMetrics& m = metrics.local("display");
+    ScopedTimer timer(m, HistogramId::DISPLAY);
+    m.add(CounterId::DISPLAY_FRAMES);
+    
+    MapStatus status = liveStatus();
+    status.tick = snap->tick;
+    const std::string frame = mapRenderer.render(*snap, status);
+    
+    auto coutLock = timedLock<std::unique_lock<std::mutex>>(coutMutex, m, HistogramId::COUT_LOCK_WAIT);
+    std::cout << frame << std::flush;
+}
+
+void Game::printSurvivors() const {
+    std::shared_ptr<const WorldSnapshot> snap = snapshots.acquire();
+    if (!snap) return;
+    
     std::lock_guard<std::mutex> coutLock(coutMutex);
     
-    std::cout << "\n=== MAP " << mapX << "x" << mapY << " ===\n";
+    std::cout << "\n=== SURVIVORS ===\n";
     
-    // Простой вывод статистики вместо графической карты
-    std::shared_lock<std::shared_mutex> lock(npcsMutex);
+    int count = 0;
+    for (size_t i = 0; i < snap->size(); ++i) {
+        if (snap->isAlive(i)) {
+            std::cout << ++count << ". " << snap->view(i).toString() << "\n";
+        }
+    }
     
-    int aliveCount = 0;
-    int deadCount = 0;
+    if (count == 0) {
+        std::cout << "No survivors!\n";
+    } else {
+        std::cout << "Total survivors: " << count << "\n";
+    }
+}
+
+SimulationReport Game::runHeadless(uint64_t ticks) {
+    using Clock = std::chrono::steady_clock;
+    auto seconds = [](Clock::duration d) {
+        return std::chrono::duration<double>(d).count();
+    };
+    
+    SimulationReport report;
+    running = true;
+    startBattlePool();
+    startMetricsExport();
+    ThreadMetrics& m = metrics.local("movement");
     
-    for (const auto& npc : npcs) {
-        if (npc->isAlive()) {
-            aliveCount++;
+    const auto startTime = Clock::now();
+    for (uint64_t tick = 0; tick < ticks; ++tick) {
+        auto t0 = Clock::now();
+        
+        // Воспроизведение: тики журнала без поиска пар, до его конца
+        if (replay) {
+            if (!replayPhase()) break;
+            m.recordSince(HistogramId::TICK, t0);
+            m.add(CounterId::TICKS);
+            report.moveSeconds += seconds(Clock::now() - t0);
+            report.ticks++;
+            continue;
+        }
+        
+        compactPhase(m);
+        movePhase();
+        publishPhase();
+        auto t1 = Clock::now();
+        detectPhase();
+        auto t2 = Clock::now();
+        
+        // Фиксированный шаг: тик заканчивается, когда разрешены все его бои
+        if (config.battleScheduler == BattleScheduler::ROUNDS) {
+            report.battlesSubmitted += resolveRounds();
         } else {
-            deadCount++;
+            report.battlesSubmitted += submitBattles();
+            battlePool->waitIdle();
         }
+        auto t3 = Clock::now();
+        if (config.battleScheduler == BattleScheduler::ROUNDS) publishSnapshot(m);
+        if (journal) journal->recordTick(world, tickCount);
+        
+        m.recordSince(HistogramId::TICK, t0);
+        m.recordDuration(HistogramId::BATTLES, t3 - t2);
+        m.add(CounterId::TICKS);
+        
+        report.moveSeconds += seconds(t1 - t0);
+        report.detectSeconds += seconds(t2 - t1);
+        report.battleSeconds += seconds(t3 - t2);
+        report.ticks++;
     }
+    report.totalSeconds = seconds(Clock::now() - startTime);
     
-    std::cout << "Alive NPCs: " << aliveCount << "\n";
-    std::cout << "Dead NPCs: " << deadCount << "\n";
+    running = false;
+    if (battlePool) {
+        battlePool->stop();
+        report.battlesDropped = battlePool->dropped();
+    }
+    report.battlesFought = battlesFought;
+    report.battleRounds = battleRoundCount;
+    report.battlesStale = battlesStale;
+    report.compactions = compactionCount;
+    report.broadphase = broadphase->stats();
+    report.battlesSuppressed = pendingPairs.suppressed();
+    battleLog->flush();
+    if (journal) {
+        journal->flush();
+        report.journalTicks = journal->ticks();
+        report.journalRawBytes = journal->rawBytes();
+        report.journalBytes = journal->storedBytes();
+    }
+    report.logWritten = battleLog->written();
+    report.logDropped = battleLog->dropped();
     
-    // Покажем первых 5 живых NPC
-    int count = 0;
-    std::cout << "Some NPCs positions:\n";
-    for (const auto& npc : npcs) {
-        if (npc->isAlive() && count < 5) {
-            std::cout << "  " << npc->getName() << " at [" 
-                      << npc->getX() << "," << npc->getY() << "]\n";
-            count++;
+    publishSnapshot(m);
+    stopMetricsExport();
+    std::shared_ptr<const WorldSnapshot> snap = snapshots.acquire();
+    report.dead = snap->removed;
+    for (size_t i = 0; i < snap->size(); ++i) {
+        if (snap->isAlive(i)) {
+            report.alive++;
+            report.aliveByType[static_cast<size_t>(snap->getType(i))]++;
+        } else {
+            report.dead++;
         }
     }
-    
-    std::cout << "---\n";
+    return report;
 }
 
-void Game::printSurvivors() const {
+void Game::printReport(const SimulationReport& report) const {
     std::lock_guard<std::mutex> coutLock(coutMutex);
     
-    std::cout << "\n=== SURVIVORS ===\n";
-    
-    std::shared_lock<std::shared_mutex> lock(npcsMutex);
+    auto perTickMs = [&report](double total) {
+        return report.ticks ? total * 1000.0 / report.ticks : 0.0;
+    };
     
-    int count = 0;
-    for (const auto& npc : npcs) {
-        if (npc->isAlive()) {
-            std::cout << ++count << ". " << npc->toString() << "\n";
-        }
+    std::cout << "\n=== HEADLESS REPORT ===\n";
+    const std::streamsize oldPrecision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Ticks: " << report.ticks << " in " << report.totalSeconds << " s ("
+              << std::setprecision(1) << report.ticksPerSecond() << " ticks/s)\n";
+    std::cout << std::setprecision(4);
+    std::cout << "Per tick, ms: move " << perTickMs(report.moveSeconds)
+              << ", detect " << perTickMs(report.detectSeconds)
+              << ", battles " << perTickMs(report.battleSeconds) << "\n";
+    std::cout << "Battles: " << report.battlesSubmitted << " queued, "
+              << report.battlesFought << " fought, "
+              << report.battlesDropped << " dropped, "
+              << report.battlesSuppressed << " duplicates suppressed, "
+              << report.battleRounds << " rounds\n";
+    if (report.broadphase.shards > 0) {
+        const BroadphaseStats& bp = report.broadphase;
+        std::cout << "Shards: " << bp.shards << " strips, " << bp.rebuilds << " re-layouts, "
+                  << bp.migrations << " migrations, "
+                  << (bp.calls ? bp.haloEntries / bp.calls : 0) << " halo NPCs/tick\n";
+    } else if (report.broadphase.rebuilds > 0) {
+        const BroadphaseStats& bp = report.broadphase;
+        uint64_t listTicks = bp.calls - bp.fallbacks;
+        std::cout << "Neighbor lists: " << bp.rebuilds << " rebuilds in " << bp.calls
+                  << " ticks, " << bp.fallbacks << " grid fallbacks, "
+                  << (listTicks ? bp.candidatesChecked / listTicks : 0)
+                  << " candidates/tick (max list " << bp.maxCandidates << ")\n";
     }
-    
-    if (count == 0) {
-        std::cout << "No survivors!\n";
-    } else {
-        std::cout << "Total survivors: " << count << "\n";
+    if (report.compactions > 0) {
+        std::cout << "Compactions: " << report.compactions << ", stale battle tasks dropped: "
+                  << report.battlesStale << "\n";
+    }
+    if (report.journalTicks > 0) {
+        std::cout << "Journal: " << report.journalTicks << " ticks, "
+                  << report.journalRawBytes / 1024 << " KiB encoded, "
+                  << report.journalBytes / 1024 << " KiB on disk\n";
+    }
+    std::cout << "Battle log: " << report.logWritten << " written, "
+              << report.logDropped << " dropped\n";
+    std::cout << "Alive: " << report.alive << ", dead: " << report.dead << "\n";
+    for (size_t t = 0; t < NPC_TYPE_COUNT; ++t) {
+        if (report.aliveByType[t] > 0) {
+            std::cout << "  " << NPC::typeToString(static_cast<NPCType>(t))
+                      << ": " << report.aliveByType[t] << "\n";
+        }
     }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout.precision(oldPrecision);
 }
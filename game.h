@@ -3,62 +3,221 @@
 
 #include "npc.h"
 #include "factory.h"
+#include "world.h"
+#include "broadphase.h"
+#include "battle_pool.h"
+#include "pending_pairs.h"
+#include "battle_rounds.h"
+#include "thread_pool.h"
+#include "snapshot.h"
+#include "battle_log.h"
+#include "world_file.h"
+#include "metrics.h"
+#include "map_renderer.h"
+#include "journal.h"
+#include <array>
 #include <vector>
 #include <memory>
 #include <thread>
 #include <mutex>
 #include <shared_mutex>
-#include <queue>
-#include <condition_variable>
 #include <atomic>
-#include <random>
 #include <chrono>
 
-struct BattleTask {
-    std::shared_ptr<NPC> attacker;
-    std::shared_ptr<NPC> defender;
+// Как разрешаются бои тика
+enum class BattleScheduler {
+    ROUNDS,  // раунды без конфликтов на пуле движения; итог зависит только от сида
+    POOL     // асинхронный пул battleWorkers потоков с очередью
+};
+
+// Параметры запуска игры
+struct GameConfig {
+    int npcCount = 50;
+    int mapX = 100;
+    int mapY = 100;
+    BroadphaseKind broadphase = BroadphaseKind::UNIFORM_GRID;
+    int shards = 0;  // для BroadphaseKind::SHARDED; 0 - по числу ядер
+    BattleScheduler battleScheduler = BattleScheduler::ROUNDS;
+    int battleWorkers = 4;  // для BattleScheduler::POOL
+    int movementThreads = 0;  // 0 - по числу ядер
+    size_t battleQueueCapacity = 65536;
+    uint64_t seed = 0;  // 0 - случайный сид
+    int durationSeconds = 30;
+    int tickMillis = 100;
+    int displayMillis = 1000;
+    int viewCols = 64;  // карта displayWorker: клеток по x и по y
+    int viewRows = 20;
+    MapStyle mapStyle = MapStyle::TEXT;
+    LogDestination battleLog = LogDestination::STDOUT;
+    std::string battleLogPath;  // для LogDestination::FILE
+    std::string loadPath;       // мир из файла снимка вместо случайного
+    std::string metricsPath;    // периодическая выгрузка метрик; пусто - не выгружать
+    MetricsFormat metricsFormat = MetricsFormat::PROMETHEUS;
+    int metricsMillis = 1000;
+    // Сжатие мира на границе тика, когда мертвых не меньше этой доли; 0 - никогда
+    double compactDeadRatio = 0.25;
+    std::string journalPath;    // журнал событий (journal.h); пусто - не писать
+    int keyframeTicks = 100;    // ключевой кадр журнала раз в столько тиков
+    std::string replayPath;     // воспроизвести журнал вместо симуляции
+    uint64_t replayFrom = 0;    // тик начала воспроизведения (перемотка)
+};
+
+// Итоги прогона без отображения (runHeadless)
+struct SimulationReport {
+    uint64_t ticks = 0;
+    double totalSeconds = 0;
+    double moveSeconds = 0;
+    double detectSeconds = 0;
+    double battleSeconds = 0;
+    uint64_t battlesSubmitted = 0;
+    uint64_t battlesFought = 0;
+    uint64_t battlesDropped = 0;
+    uint64_t battlesSuppressed = 0;  // пара уже ждала боя
+    uint64_t battleRounds = 0;       // раундов без конфликтов (ROUNDS)
+    uint64_t battlesStale = 0;       // задачи, пережившие сжатие мира
+    uint64_t compactions = 0;
+    uint64_t journalTicks = 0;
+    uint64_t journalRawBytes = 0;
+    uint64_t journalBytes = 0;       // в файле, после сжатия
+    BroadphaseStats broadphase;
+    uint64_t logWritten = 0;
+    uint64_t logDropped = 0;
+    size_t alive = 0;
+    size_t dead = 0;
+    std::array<size_t, NPC_TYPE_COUNT> aliveByType{};
+    
+    double ticksPerSecond() const { return totalSeconds > 0 ? ticks / totalSeconds : 0; }
 };
 
 class Game {
 private:
-    std::vector<std::shared_ptr<NPC>> npcs;
-    mutable std::shared_mutex npcsMutex;
+    GameConfig config;
+    
+    // Счетчики и гистограммы потоков: каждый поток пишет в свой блок
+    mutable Metrics metrics;
+    std::unique_ptr<MetricsExporter> metricsExporter;
     
-    std::queue<BattleTask> battleQueue;
-    std::mutex battleQueueMutex;
-    std::condition_variable battleCV;
+    World world;
+    mutable std::shared_mutex npcsMutex;  // обмен буферов позиций и состав world
+    
+    // Движение считается кусками по MOVE_CHUNK NPC на пуле потоков.
+    // У каждого куска свой генератор от (сида, тика, номера куска),
+    // поэтому результат не зависит от числа потоков.
+    static constexpr size_t MOVE_CHUNK = 4096;
+    std::unique_ptr<ThreadPool> movementPool;
+    std::atomic<uint64_t> tickCount{0};
+    
+    // Снимок мира публикуется раз в тик; наблюдатели не трогают npcsMutex
+    SnapshotPublisher snapshots;
+    
+    // Бои разрешаются пулом потоков без блокировок мира: оба участника
+    // захватываются в своих словах жизни (World::tryFight), поэтому NPC
+    // погибает не более одного раза, а погибший больше не побеждает.
+    std::unique_ptr<BattlePool> battlePool;
+    
+    // Пары, бой которых уже в очереди: каждая ставится не более одного раза
+    PendingPairs pendingPairs;
+    
+    // Режим ROUNDS: бои тика раскладываются по раундам, где NPC
+    // встречается не более раза, и раунд целиком идет параллельно
+    static constexpr size_t ROUND_GRAIN = 256;
+    BattleRoundPlanner roundPlanner;
+    std::atomic<uint64_t> battleRoundCount{0};
     
     std::atomic<bool> running{true};
     std::atomic<int> mapX{100};
     std::atomic<int> mapY{100};
     
+    std::unique_ptr<Broadphase> broadphase;
+    std::vector<BattlePair> battlePairs;
+    std::vector<BattleTask> battleBatch;  // бои тика, публикуются одной пачкой
+    
     std::thread movementThread;
-    std::thread battleThread;
     std::thread displayThread;
     
+    std::atomic<uint64_t> battlesFought{0};
+    
+    // Живые по типам: уменьшаются при каждом убийстве, поэтому вывод
+    // берет счетчики готовыми, а не проходит по NPC
+    std::array<std::atomic<size_t>, NPC_TYPE_COUNT> aliveCounts{};
+    size_t npcTotal = 0;
+    
+    // Сжатие: мертвые в мире считаются по убийствам, без прохода по NPC.
+    // Задачи пула из прошлого поколения мира отбрасываются в resolveBattle.
+    size_t initialDead = 0;
+    uint64_t compactionCount = 0;
+    std::atomic<uint64_t> battlesStale{0};
+    
     mutable std::mutex coutMutex;  // Добавляем mutable
     
+    // Кадры карты; рисует только поток отображения
+    mutable MapRenderer mapRenderer;
+    
+    // Бои пишутся в асинхронный журнал, а не в cout из потоков боев
+    std::unique_ptr<BattleLog> battleLog;
+    
+    // Журнал событий: сдвиги и исходы боев каждого тика. При
+    // воспроизведении тики берутся из журнала, случайность не нужна.
+    std::unique_ptr<JournalWriter> journal;
+    std::unique_ptr<JournalReader> replay;
+    JournalTick replayStep;
+    
+    void startBattlePool();
+    void startMetricsExport();
+    void stopMetricsExport();
+    void compactPhase(ThreadMetrics& m);
+    bool replayPhase();
+    void movePhase();
+    void publishPhase();
+    void detectPhase();
+    size_t submitBattles();
+    size_t resolveRounds();
+    void publishSnapshot(ThreadMetrics& m);
     void movementWorker();
-    void battleWorker();
+    void resolveBattle(const BattleTask& task);
+    void fightBattle(const BattleTask& task);
+    void fightBattle(NPCHandle attacker, NPCHandle defender, bool attackerWins);
+    bool resolveKill(NPCHandle attacker, NPCHandle defender, bool attackerWins);
     void displayWorker();
     
     bool rollDice() {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(1, 6);
-        int attack = dis(gen);
-        int defense = dis(gen);
+        Xoshiro256& gen = Rng::local();
+        int attack = gen.uniform(1, 6);
+        int defense = gen.uniform(1, 6);
         return attack > defense;
     }
     
+    // Кубики от ключа боя: результат не зависит от потока
+    static bool rollDice(uint64_t key) { return attackerWinsDice(key); }
+    
 public:
     Game();
+    explicit Game(const GameConfig& config);
     ~Game();
     
     void start();
     void stop();
     void printMap() const;
     void printSurvivors() const;
+    
+    // Счетчики живых и мертвых на текущий момент, без прохода по NPC
+    MapStatus liveStatus() const;
+    
+    // Последний опубликованный снимок мира (для вывода и экспорта)
+    std::shared_ptr<const WorldSnapshot> snapshot() const { return snapshots.acquire(); }
+    
+    // Сохраняет последний опубликованный снимок в файл; можно вызывать из
+    // любого потока во время игры. Возвращает тик снимка. В режиме ROUNDS
+    // снимок - граница тика (после его боев), в режиме POOL он снят до
+    // боев тика: они идут в пуле уже после публикации.
+    uint64_t saveSnapshot(const std::string& path) const;
+    
+    // Сводка метрик всех потоков по ролям (movement, battle, display)
+    MetricsSnapshot metricsSnapshot() const { return metrics.snapshot(); }
+    
+    // Прогон ticks тиков без пауз и без потока отображения
+    SimulationReport runHeadless(uint64_t ticks);
+    void printReport(const SimulationReport& report) const;
 };
 
 #endif
@@ -0,0 +1,389 @@
+#include "journal.h"
+#include "lz_block.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+JournalWriter::JournalWriter(const std::string& path, const World& world, uint64_t tick,
+                             int mapX, int mapY, uint64_t seed, int keyframeTicks)
+    : file(path, std::ios::binary | std::ios::trunc), keyframeTicks(std::max(keyframeTicks, 0)) {
+    if (!file) throw std::runtime_error("cannot create journal: " + path);
+
+    WireWriter head;
+    head.putBytes(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    head.put32(JOURNAL_VERSION);
+    head.put32(static_cast<uint32_t>(this->keyframeTicks));
+    head.put64(seed);
+    head.put32(static_cast<uint32_t>(mapX));
+    head.put32(static_cast<uint32_t>(mapY));
+    head.put32(static_cast<uint32_t>(world.size()));
+    head.put32(0);
+    head.put64(tick);
+    file.write(reinterpret_cast<const char*>(head.data().data()),
+               static_cast<std::streamsize>(head.size()));
+
+    // Статика: мир еще не сжимался, поэтому индекс равен id
+    WireWriter fixed;
+    fixed.putVar(world.size());
+    std::string name;
+    for (size_t i = 0; i < world.size(); ++i) {
+        const NPCHandle h = world.handle(i);
+        fixed.put8(static_cast<uint8_t>(world.getType(h)));
+        fixed.putVar(static_cast<uint64_t>(world.getMoveDistance(h)));
+        fixed.putVar(static_cast<uint64_t>(world.getKillDistance(h)));
+        name = world.getName(h);
+        fixed.putVar(name.size());
+        fixed.putBytes(name.data(), name.size());
+    }
+
+    writer = std::thread(&JournalWriter::writerLoop, this);
+    submit({JournalBlock::STATICS, 0, tick, fixed.data()});
+    writeKeyframe(world, tick);
+}
+
+JournalWriter::~JournalWriter() {
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCV.notify_all();
+    if (writer.joinable()) writer.join();
+}
+
+void JournalWriter::recordBattle(const BattleRecord& rec) {
+    std::lock_guard<std::mutex> lock(battlesMutex);
+    battles.push_back(rec);
+}
+
+void JournalWriter::recordTick(const World& world, uint64_t tick) {
+    if (ticksInBlock == 0) ticksFirst = tick;
+
+    // Сдвиги: мертвые не двигаются, поэтому в записи только живые
+    const auto& xs = world.xs();
+    const auto& ys = world.ys();
+    const auto& prevX = world.previousXs();
+    const auto& prevY = world.previousYs();
+    const auto& ids = world.ids();
+    scratch.clear();
+    uint64_t moves = 0;
+    NPCId lastId = 0;
+    for (size_t i = 0; i < world.size(); ++i) {
+        if (xs[i] == prevX[i] && ys[i] == prevY[i]) continue;
+        scratch.putVar(ids[i] - lastId);
+        scratch.putSignedVar(static_cast<int64_t>(xs[i]) - prevX[i]);
+        scratch.putSignedVar(static_cast<int64_t>(ys[i]) - prevY[i]);
+        lastId = ids[i];
+        moves++;
+    }
+    ticksData.putVar(moves);
+    ticksData.putBytes(scratch.data().data(), scratch.size());
+
+    {
+        std::lock_guard<std::mutex> lock(battlesMutex);
+        drained.swap(battles);
+    }
+    ticksData.putVar(drained.size());
+    for (const BattleRecord& rec : drained) {
+        ticksData.putVar(rec.attacker);
+        ticksData.putVar(rec.defender);
+        ticksData.put8(rec.attackerWins ? 1 : 0);
+    }
+    drained.clear();
+
+    ticksInBlock++;
+    tickCount++;
+    if (ticksData.size() >= TICKS_BLOCK_BYTES) sealTicks();
+    if (keyframeTicks > 0 && tick % static_cast<uint64_t>(keyframeTicks) == 0) {
+        sealTicks();
+        writeKeyframe(world, tick);
+    }
+}
+
+void JournalWriter::writeKeyframe(const World& world, uint64_t tick) {
+    const auto& xs = world.xs();
+    const auto& ys = world.ys();
+    const auto& ids = world.ids();
+    WireWriter frame;
+    scratch.clear();
+    uint64_t alive = 0;
+    NPCId lastId = 0;
+    for (size_t i = 0; i < world.size(); ++i) {
+        const uint32_t word = world.lifeWord(i);
+        if (!NPCLife::alive(word)) continue;
+        scratch.putVar(ids[i] - lastId);
+        scratch.putSignedVar(xs[i]);
+        scratch.putSignedVar(ys[i]);
+        scratch.putVar(static_cast<uint64_t>(NPCLife::health(word)));
+        lastId = ids[i];
+        alive++;
+    }
+    frame.putVar(alive);
+    frame.putBytes(scratch.data().data(), scratch.size());
+    submit({JournalBlock::KEYFRAME, 0, tick, frame.data()});
+}
+
+void JournalWriter::sealTicks() {
+    if (ticksInBlock == 0) return;
+    submit({JournalBlock::TICKS, ticksInBlock, ticksFirst, ticksData.data()});
+    ticksData.clear();
+    ticksInBlock = 0;
+}
+
+void JournalWriter::submit(Block block) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    spaceCV.wait(lock, [this]() { return queue.size() < MAX_QUEUED_BLOCKS; });
+    queue.push_back(std::move(block));
+    lock.unlock();
+    queueCV.notify_one();
+}
+
+bool JournalWriter::flush() {
+    sealTicks();
+    std::unique_lock<std::mutex> lock(queueMutex);
+    spaceCV.wait(lock, [this]() { return queue.empty() && !writing; });
+    file.flush();
+    if (!file) failed = true;
+    return !failed;
+}
+
+void JournalWriter::writeBlock(const Block& block) {
+    // Сжатый блок пишется, только если он меньше сырого
+    std::vector<uint8_t> packed;
+    lzCompress(block.raw.data(), block.raw.size(), packed);
+    const bool compressed = packed.size() < block.raw.size();
+    const std::vector<uint8_t>& stored = compressed ? packed : block.raw;
+
+    WireWriter head;
+    head.put8(static_cast<uint8_t>(block.kind));
+    head.put8(static_cast<uint8_t>(compressed ? JournalCodec::LZ : JournalCodec::RAW));
+    head.put16(0);
+    head.put32(block.tickCount);
+    head.put64(block.firstTick);
+    head.put32(static_cast<uint32_t>(block.raw.size()));
+    head.put32(static_cast<uint32_t>(stored.size()));
+    file.write(reinterpret_cast<const char*>(head.data().data()),
+               static_cast<std::streamsize>(head.size()));
+    file.write(reinterpret_cast<const char*>(stored.data()),
+               static_cast<std::streamsize>(stored.size()));
+    if (!file) failed = true;
+
+    rawByteCount += block.raw.size();
+    storedByteCount += JOURNAL_BLOCK_HEADER_SIZE + stored.size();
+    blockCount++;
+}
+
+void JournalWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (true) {
+        queueCV.wait(lock, [this]() { return !queue.empty() || stopping; });
+        if (queue.empty()) return;
+
+        Block block = std::move(queue.front());
+        queue.pop_front();
+        writing = true;
+        lock.unlock();
+        writeBlock(block);
+        lock.lock();
+        writing = false;
+        spaceCV.notify_all();
+    }
+}
+
+JournalReader::JournalReader(const std::string& path) : file(path, std::ios::binary) {
+    if (!file) throw std::runtime_error("cannot open journal: " + path);
+
+    std::vector<uint8_t> head(JOURNAL_HEADER_SIZE);
+    if (!file.read(reinterpret_cast<char*>(head.data()), JOURNAL_HEADER_SIZE)) {
+        throw std::runtime_error("journal too short: " + path);
+    }
+    WireReader in(head);
+    if (std::memcmp(in.getBytes(sizeof(JOURNAL_MAGIC)), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+        throw std::runtime_error("not a journal: " + path);
+    }
+    if (in.get32() != JOURNAL_VERSION) throw std::runtime_error("unsupported journal version: " + path);
+    header.keyframeTicks = in.get32();
+    header.seed = in.get64();
+    header.mapX = static_cast<int32_t>(in.get32());
+    header.mapY = static_cast<int32_t>(in.get32());
+    header.npcCount = in.get32();
+    in.get32();
+    header.startTick = in.get64();
+
+    // Оглавление блоков; оборванный последний блок отбрасывается
+    file.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    uint64_t offset = JOURNAL_HEADER_SIZE;
+    std::vector<uint8_t> blockHead(JOURNAL_BLOCK_HEADER_SIZE);
+    finalTick = header.startTick;
+    while (offset + JOURNAL_BLOCK_HEADER_SIZE <= fileSize) {
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(reinterpret_cast<char*>(blockHead.data()), JOURNAL_BLOCK_HEADER_SIZE);
+        WireReader b(blockHead);
+        BlockInfo info;
+        info.kind = static_cast<JournalBlock>(b.get8());
+        info.codec = static_cast<JournalCodec>(b.get8());
+        b.get16();
+        info.tickCount = b.get32();
+        info.firstTick = b.get64();
+        info.rawSize = b.get32();
+        info.storedSize = b.get32();
+        info.offset = offset + JOURNAL_BLOCK_HEADER_SIZE;
+        if (info.offset + info.storedSize > fileSize) break;
+        if (info.kind < JournalBlock::STATICS || info.kind > JournalBlock::TICKS ||
+            info.codec > JournalCodec::LZ) {
+            throw std::runtime_error("corrupt journal block header: " + path);
+        }
+        if (info.kind == JournalBlock::TICKS) {
+            finalTick = std::max(finalTick, info.firstTick + info.tickCount - 1);
+        }
+        blocks.push_back(info);
+        offset = info.offset + info.storedSize;
+    }
+    file.clear();
+
+    if (blocks.empty() || blocks[0].kind != JournalBlock::STATICS) {
+        throw std::runtime_error("journal has no NPC table: " + path);
+    }
+    readStatics(blocks[0]);
+    if (keyframes() == 0) throw std::runtime_error("journal has no keyframe: " + path);
+}
+
+size_t JournalReader::keyframes() const {
+    return static_cast<size_t>(std::count_if(blocks.begin(), blocks.end(), [](const BlockInfo& b) {
+        return b.kind == JournalBlock::KEYFRAME;
+    }));
+}
+
+std::vector<uint8_t> JournalReader::readBlock(const BlockInfo& block) {
+    std::vector<uint8_t> stored(block.storedSize);
+    file.seekg(static_cast<std::streamoff>(block.offset));
+    if (!file.read(reinterpret_cast<char*>(stored.data()), block.storedSize)) {
+        throw std::runtime_error("cannot read journal block");
+    }
+    if (block.codec == JournalCodec::RAW) {
+        if (block.rawSize != block.storedSize) throw std::runtime_error("corrupt journal block");
+        return stored;
+    }
+    std::vector<uint8_t> raw;
+    lzDecompress(stored.data(), stored.size(), block.rawSize, raw);
+    return raw;
+}
+
+void JournalReader::readStatics(const BlockInfo& block) {
+    const std::vector<uint8_t> raw = readBlock(block);
+    WireReader in(raw);
+    const uint64_t count = in.getVar();
+    if (count != header.npcCount) throw std::runtime_error("journal NPC table size mismatch");
+
+    auto fixed = std::make_shared<NPCStatics>();
+    fixed->type.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint8_t type = in.get8();
+        if (type >= NPC_TYPE_COUNT) throw std::runtime_error("corrupt journal NPC table");
+        fixed->type.push_back(static_cast<NPCType>(type));
+        fixed->moveDistance.push_back(static_cast<int>(in.getVar()));
+        fixed->killDistance.push_back(static_cast<int>(in.getVar()));
+        const size_t length = static_cast<size_t>(in.getVar());
+        const char* name = reinterpret_cast<const char*>(in.getBytes(length));
+        fixed->nameIds.push_back(encodeName(fixed->nameTable, fixed->type.back(),
+                                            std::string(name, length)));
+        fixed->id.push_back(static_cast<NPCId>(i));
+    }
+    statics = std::move(fixed);
+}
+
+World JournalReader::seek(uint64_t tick) {
+    if (tick < header.startTick || tick > finalTick) {
+        throw std::invalid_argument("tick " + std::to_string(tick) + " is outside the journal (" +
+                                    std::to_string(header.startTick) + ".." +
+                                    std::to_string(finalTick) + ")");
+    }
+
+    size_t key = blocks.size();
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (blocks[b].kind == JournalBlock::KEYFRAME && blocks[b].firstTick <= tick) key = b;
+    }
+    if (key == blocks.size()) throw std::runtime_error("no keyframe before tick " + std::to_string(tick));
+
+    // Не упомянутые в ключевом кадре NPC мертвы
+    const size_t count = header.npcCount;
+    std::vector<int> xs(count, 0), ys(count, 0), health(count, 0);
+    std::vector<uint8_t> alive(count, 0);
+    const std::vector<uint8_t> raw = readBlock(blocks[key]);
+    WireReader in(raw);
+    const uint64_t aliveCount = in.getVar();
+    uint64_t id = 0;
+    for (uint64_t k = 0; k < aliveCount; ++k) {
+        id += in.getVar();
+        if (id >= count) throw std::runtime_error("corrupt journal keyframe");
+        xs[id] = static_cast<int>(in.getSignedVar());
+        ys[id] = static_cast<int>(in.getSignedVar());
+        health[id] = static_cast<int>(in.getVar());
+        alive[id] = 1;
+    }
+    World world = World::fromColumns(std::move(xs), std::move(ys), std::move(alive),
+                                     std::move(health), *statics);
+
+    nextBlock = key + 1;
+    ticksLeft = 0;
+    cursor.reset();
+    nextTick = blocks[key].firstTick + 1;
+
+    JournalTick step;
+    while (nextTick <= tick && next(step)) {
+        applyMoves(world, step);
+        for (const BattleRecord& rec : step.battles) {
+            world.kill(world.handle(rec.attackerWins ? rec.defender : rec.attacker));
+        }
+    }
+    return world;
+}
+
+bool JournalReader::next(JournalTick& out) {
+    while (ticksLeft == 0) {
+        while (nextBlock < blocks.size() && blocks[nextBlock].kind != JournalBlock::TICKS) nextBlock++;
+        if (nextBlock == blocks.size()) return false;
+        const BlockInfo& block = blocks[nextBlock++];
+        if (block.firstTick + block.tickCount <= nextTick) continue;  // уже пройден
+        if (block.firstTick != nextTick) throw std::runtime_error("journal tick sequence broken");
+        current = readBlock(block);
+        cursor = std::make_unique<WireReader>(current);
+        ticksLeft = block.tickCount;
+    }
+
+    out.tick = nextTick++;
+    ticksLeft--;
+    out.moves.clear();
+    out.battles.clear();
+
+    const uint64_t moves = cursor->getVar();
+    NPCId id = 0;
+    for (uint64_t k = 0; k < moves; ++k) {
+        id += static_cast<NPCId>(cursor->getVar());
+        if (id >= header.npcCount) throw std::runtime_error("corrupt journal tick");
+        int dx = static_cast<int>(cursor->getSignedVar());
+        int dy = static_cast<int>(cursor->getSignedVar());
+        out.moves.push_back({id, dx, dy});
+    }
+    const uint64_t battles = cursor->getVar();
+    for (uint64_t k = 0; k < battles; ++k) {
+        BattleRecord rec;
+        rec.tick = static_cast<uint32_t>(out.tick);
+        rec.attacker = static_cast<NPCId>(cursor->getVar());
+        rec.defender = static_cast<NPCId>(cursor->getVar());
+        rec.attackerWins = cursor->get8();
+        if (rec.attacker >= header.npcCount || rec.defender >= header.npcCount) {
+            throw std::runtime_error("corrupt journal tick");
+        }
+        out.battles.push_back(rec);
+    }
+    return true;
+}
+
+void JournalReader::applyMoves(World& world, const JournalTick& tick) {
+    for (const JournalMove& move : tick.moves) {
+        const NPCHandle h = world.handle(move.id);
+        world.setPosition(h, world.getX(h) + move.dx, world.getY(h) + move.dy);
+    }
+}
@@ -0,0 +1,198 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "world.h"
+#include "wire.h"
+#include "battle_log.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Журнал событий игры: только дописывание, блоками, little-endian.
+//
+//   заголовок: "L7JOURNL" | u32 версия | u32 шаг ключевых кадров | u64 сид |
+//              i32 mapX | i32 mapY | u32 число NPC | u32 0 | u64 первый тик
+//   блок:      u8 вид | u8 сжатие | u16 0 | u32 тиков | u64 первый тик |
+//              u32 сырой размер | u32 размер в файле | данные
+//
+// Виды блоков (числа внутри - varint, со знаком - zigzag):
+//   STATICS  - для каждого NPC по NPCStatics::id: тип, дистанции, имя;
+//   KEYFRAME - состояние на тике: живые NPC (шаг id, x, y, здоровье);
+//   TICKS    - записи тиков подряд: сдвиги позиций (шаг id, dx, dy)
+//              и исходы боев тика (BattleRecord по id).
+// Блоки TICKS режутся по размеру и перед каждым ключевым кадром, поэтому
+// перемотка - это ближайший ключевой кадр и тики после него.
+//
+// Журнал, оборванный на середине блока (падение), читается до последнего
+// целого блока.
+
+constexpr char JOURNAL_MAGIC[8] = {'L', '7', 'J', 'O', 'U', 'R', 'N', 'L'};
+constexpr uint32_t JOURNAL_VERSION = 1;
+constexpr size_t JOURNAL_HEADER_SIZE = 48;
+constexpr size_t JOURNAL_BLOCK_HEADER_SIZE = 24;
+
+enum class JournalBlock : uint8_t {
+    STATICS = 1,
+    KEYFRAME,
+    TICKS
+};
+
+enum class JournalCodec : uint8_t {
+    RAW = 0,
+    LZ      // lz_block.h
+};
+
+struct JournalInfo {
+    uint32_t keyframeTicks = 0;
+    uint64_t seed = 0;
+    int mapX = 0;
+    int mapY = 0;
+    uint32_t npcCount = 0;
+    uint64_t startTick = 0;
+};
+
+// Запись журнала из игры. Позиции и ключевые кадры пишет поток движения
+// в конце тика; исходы боев - любой поток. Сжатие и запись в файл - в
+// фоновом потоке; если он отстал на MAX_QUEUED_BLOCKS блоков, запись тика
+// ждет его (журнал не теряет событий).
+class JournalWriter {
+public:
+    // Заголовок, статика NPC и ключевой кадр на тике tick
+    JournalWriter(const std::string& path, const World& world, uint64_t tick,
+                  int mapX, int mapY, uint64_t seed, int keyframeTicks);
+    ~JournalWriter();
+
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    // Исход боя с участниками по NPCStatics::id
+    void recordBattle(const BattleRecord& rec);
+
+    // Тик закончен: сдвиги позиций с прошлого тика и бои, пришедшие с
+    // прошлой записи. Вызывает только поток, двигающий мир.
+    void recordTick(const World& world, uint64_t tick);
+
+    // Закрывает открытый блок и ждет, пока все блоки будут в файле.
+    // false - запись в файл не удалась.
+    bool flush();
+
+    uint64_t ticks() const { return tickCount; }
+    uint64_t rawBytes() const { return rawByteCount; }
+    uint64_t storedBytes() const { return storedByteCount; }
+    uint64_t blocks() const { return blockCount; }
+
+private:
+    static constexpr size_t TICKS_BLOCK_BYTES = 256 * 1024;
+    static constexpr size_t MAX_QUEUED_BLOCKS = 16;
+
+    struct Block {
+        JournalBlock kind;
+        uint32_t tickCount;
+        uint64_t firstTick;
+        std::vector<uint8_t> raw;
+    };
+
+    std::ofstream file;
+    const int keyframeTicks;
+
+    // Открытый блок TICKS (только поток движения)
+    WireWriter ticksData;
+    WireWriter scratch;
+    uint64_t ticksFirst = 0;
+    uint32_t ticksInBlock = 0;
+
+    std::mutex battlesMutex;
+    std::vector<BattleRecord> battles;
+    std::vector<BattleRecord> drained;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCV;  // новый блок или остановка
+    std::condition_variable spaceCV;  // блок записан
+    std::deque<Block> queue;
+    bool writing = false;
+    bool stopping = false;
+    std::thread writer;
+
+    std::atomic<bool> failed{false};
+    std::atomic<uint64_t> tickCount{0};
+    std::atomic<uint64_t> rawByteCount{0};
+    std::atomic<uint64_t> storedByteCount{0};
+    std::atomic<uint64_t> blockCount{0};
+
+    void writeKeyframe(const World& world, uint64_t tick);
+    void sealTicks();
+    void submit(Block block);
+    void writeBlock(const Block& block);
+    void writerLoop();
+};
+
+struct JournalMove {
+    NPCId id;
+    int dx;
+    int dy;
+};
+
+// Один тик из журнала
+struct JournalTick {
+    uint64_t tick = 0;
+    std::vector<JournalMove> moves;
+    std::vector<BattleRecord> battles;
+};
+
+// Чтение журнала для воспроизведения. Мир воспроизведения не сжимается:
+// индекс NPC в нем равен NPCStatics::id.
+class JournalReader {
+public:
+    explicit JournalReader(const std::string& path);
+
+    const JournalInfo& info() const { return header; }
+    uint64_t firstTick() const { return header.startTick; }
+    uint64_t lastTick() const { return finalTick; }
+    size_t keyframes() const;
+
+    // Мир на тике tick: ближайший ключевой кадр не позже tick и тики
+    // после него. next() продолжит с tick + 1.
+    World seek(uint64_t tick);
+
+    // Следующий тик; false - журнал кончился
+    bool next(JournalTick& out);
+
+    // Сдвиги позиций тика (убийства применяет вызывающий)
+    static void applyMoves(World& world, const JournalTick& tick);
+
+private:
+    struct BlockInfo {
+        JournalBlock kind;
+        JournalCodec codec;
+        uint32_t tickCount;
+        uint64_t firstTick;
+        uint32_t rawSize;
+        uint32_t storedSize;
+        uint64_t offset;  // данных блока в файле
+    };
+
+    std::ifstream file;
+    JournalInfo header;
+    std::vector<BlockInfo> blocks;
+    uint64_t finalTick = 0;
+    std::shared_ptr<const NPCStatics> statics;
+
+    // Позиция воспроизведения: блок TICKS и запись в нем
+    size_t nextBlock = 0;
+    std::vector<uint8_t> current;
+    std::unique_ptr<WireReader> cursor;
+    uint32_t ticksLeft = 0;
+    uint64_t nextTick = 0;
+
+    std::vector<uint8_t> readBlock(const BlockInfo& block);
+    void readStatics(const BlockInfo& block);
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "kill_kernel.h"
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define LAB07_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+uint32_t killMaskScalar(int ax, int ay, int killDistance,
+                        const int* xs, const int* ys, size_t count) {
+    const int64_t limit = static_cast<int64_t>(killDistance) * killDistance;
+    uint32_t mask = 0;
+    for (size_t k = 0; k < count; ++k) {
+        int64_t dx = static_cast<int64_t>(xs[k]) - ax;
+        int64_t dy = static_cast<int64_t>(ys[k]) - ay;
+        if (dx * dx + dy * dy <= limit) {
+            mask |= 1u << k;
+        }
+    }
+    return mask;
+}
+
+#ifdef LAB07_X86_SIMD
+
+__attribute__((target("sse4.1")))
+static uint32_t killMaskSSE41(int ax, int ay, int killDistance,
+                              const int* xs, const int* ys, size_t count) {
+    const __m128i vax = _mm_set1_epi32(ax);
+    const __m128i vay = _mm_set1_epi32(ay);
+    const __m128i vclamp = _mm_set1_epi32(killDistance + 1);
+    const __m128i vlimit = _mm_set1_epi32(killDistance * killDistance);
+
+    uint32_t mask = 0;
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + k));
+        __m128i py = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + k));
+        __m128i dx = _mm_min_epi32(_mm_abs_epi32(_mm_sub_epi32(px, vax)), vclamp);
+        __m128i dy = _mm_min_epi32(_mm_abs_epi32(_mm_sub_epi32(py, vay)), vclamp);
+        __m128i d2 = _mm_add_epi32(_mm_mullo_epi32(dx, dx), _mm_mullo_epi32(dy, dy));
+        __m128i outside = _mm_cmpgt_epi32(d2, vlimit);
+        uint32_t outsideBits = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(outside)));
+        mask |= (~outsideBits & 0xFu) << k;
+    }
+    if (k < count) {
+        mask |= killMaskScalar(ax, ay, killDistance, xs + k, ys + k, count - k) << k;
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+static uint32_t killMaskAVX2(int ax, int ay, int killDistance,
+                             const int* xs, const int* ys, size_t count) {
+    const __m256i vax = _mm256_set1_epi32(ax);
+    const __m256i vay = _mm256_set1_epi32(ay);
+    const __m256i vclamp = _mm256_set1_epi32(killDistance + 1);
+    const __m256i vlimit = _mm256_set1_epi32(killDistance * killDistance);
+
+    uint32_t mask = 0;
+    size_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + k));
+        __m256i py = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + k));
+        __m256i dx = _mm256_min_epi32(_mm256_abs_epi32(_mm256_sub_epi32(px, vax)), vclamp);
+        __m256i dy = _mm256_min_epi32(_mm256_abs_epi32(_mm256_sub_epi32(py, vay)), vclamp);
+        __m256i d2 = _mm256_add_epi32(_mm256_mullo_epi32(dx, dx), _mm256_mullo_epi32(dy, dy));
+        __m256i outside = _mm256_cmpgt_epi32(d2, vlimit);
+        uint32_t outsideBits = static_cast<uint32_t>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(outside)));
+        mask |= (~outsideBits & 0xFFu) << k;
+    }
+    if (k < count) {
+        mask |= killMaskScalar(ax, ay, killDistance, xs + k, ys + k, count - k) << k;
+    }
+    return mask;
+}
+
+#endif
+
+SimdLevel detectSimdLevel() {
+#ifdef LAB07_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE41;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SCALAR: return "scalar";
+        case SimdLevel::SSE41: return "sse4.1";
+        case SimdLevel::AVX2: return "avx2";
+    }
+    return "unknown";
+}
+
+KillMaskFn killKernelFor(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SCALAR: return killMaskScalar;
+#ifdef LAB07_X86_SIMD
+        case SimdLevel::SSE41: return killMaskSSE41;
+        case SimdLevel::AVX2: return killMaskAVX2;
+#endif
+        default: return nullptr;
+    }
+}
+
+static std::atomic<KillMaskFn> activeKernel{nullptr};
+static std::atomic<SimdLevel> activeLevel{SimdLevel::SCALAR};
+
+bool setKillKernel(SimdLevel level) {
+    if (static_cast<int>(level) > static_cast<int>(detectSimdLevel())) return false;
+
+    KillMaskFn fn = killKernelFor(level);
+    if (!fn) return false;
+
+    activeLevel = level;
+    activeKernel = fn;
+    return true;
+}
+
+SimdLevel activeKillKernel() {
+    if (!activeKernel.load(std::memory_order_acquire)) {
+        setKillKernel(detectSimdLevel());
+    }
+    return activeLevel;
+}
+
+uint32_t killMask(int ax, int ay, int killDistance,
+                  const int* xs, const int* ys, size_t count) {
+    KillMaskFn fn = activeKernel.load(std::memory_order_relaxed);
+    if (!fn) {
+        setKillKernel(detectSimdLevel());
+        fn = activeKernel.load(std::memory_order_relaxed);
+    }
+    if (killDistance > MAX_SIMD_KILL_DISTANCE) {
+        fn = killMaskScalar;
+    }
+    return fn(ax, ay, killDistance, xs, ys, count);
+}
@@ -0,0 +1,61 @@
+#ifndef KILL_KERNEL_H
+#define KILL_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Сколько кандидатов проверяет один вызов ядра (по биту на кандидата)
+constexpr size_t KILL_BLOCK = 32;
+
+// Наборы инструкций для ядра проверки дистанции убийства
+enum class SimdLevel {
+    SCALAR,
+    SSE41,
+    AVX2
+};
+
+// Проверяет одного NPC (ax, ay, killDistance) против блока кандидатов
+// xs[0..count), ys[0..count), count <= KILL_BLOCK. Бит k результата
+// выставлен, если dx*dx + dy*dy <= killDistance^2 для кандидата k.
+using KillMaskFn = uint32_t (*)(int ax, int ay, int killDistance,
+                                const int* xs, const int* ys, size_t count);
+
+uint32_t killMaskScalar(int ax, int ay, int killDistance,
+                        const int* xs, const int* ys, size_t count);
+
+// Векторные версии ограничивают |dx| и |dy| значением killDistance + 1:
+// результат сравнения от этого не меняется, а сумма квадратов
+// 2 * (killDistance + 1)^2 должна поместиться в int32. Для больших
+// дистанций killMask берет скалярную версию.
+constexpr int MAX_SIMD_KILL_DISTANCE = 32766;
+
+// Лучший набор инструкций, который поддерживает процессор
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+
+// Реализация для заданного уровня (nullptr, если она не собрана)
+KillMaskFn killKernelFor(SimdLevel level);
+
+// Выбор активной реализации; false, если процессор ее не поддерживает
+bool setKillKernel(SimdLevel level);
+SimdLevel activeKillKernel();
+
+// Вызов активной реализации (выбирается при первом обращении)
+uint32_t killMask(int ax, int ay, int killDistance,
+                  const int* xs, const int* ys, size_t count);
+
+// Номер младшего выставленного бита маски (mask != 0)
+inline int lowestBit(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#else
+    int bit = 0;
+    while (!(mask & 1u)) {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include "lz_block.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 14;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hash4(uint32_t v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void putLength(std::vector<uint8_t>& out, size_t extra) {
+    while (extra >= 255) {
+        out.push_back(255);
+        extra -= 255;
+    }
+    out.push_back(static_cast<uint8_t>(extra));
+}
+
+void putSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount,
+                 size_t offset, size_t matchLength) {
+    const size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+    out.push_back(static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4 |
+                                       (matchCode < 15 ? matchCode : 15)));
+    if (literalCount >= 15) putLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+    if (matchLength == 0) return;
+
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (matchCode >= 15) putLength(out, matchCode - 15);
+}
+
+size_t getLength(const uint8_t*& p, const uint8_t* end) {
+    size_t extra = 0;
+    uint8_t b;
+    do {
+        if (p == end) throw std::runtime_error("corrupt compressed block");
+        b = *p++;
+        extra += b;
+    } while (b == 255);
+    return extra;
+}
+
+}
+
+void lzCompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    std::vector<uint32_t> table(size_t{1} << HASH_BITS, UINT32_MAX);
+    size_t anchor = 0;
+    size_t i = 0;
+
+    while (size >= MIN_MATCH && i + MIN_MATCH <= size) {
+        const uint32_t v = read32(data + i);
+        const uint32_t h = hash4(v);
+        const uint32_t candidate = table[h];
+        table[h] = static_cast<uint32_t>(i);
+
+        if (candidate == UINT32_MAX || i - candidate > MAX_OFFSET || read32(data + candidate) != v) {
+            i++;
+            continue;
+        }
+
+        size_t length = MIN_MATCH;
+        while (i + length < size && data[candidate + length] == data[i + length]) length++;
+        putSequence(out, data + anchor, i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+    }
+    putSequence(out, data + anchor, size - anchor, 0, 0);
+}
+
+void lzDecompress(const uint8_t* data, size_t size, size_t rawSize, std::vector<uint8_t>& out) {
+    const size_t base = out.size();
+    out.reserve(base + rawSize);
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+
+    while (p < end) {
+        const uint8_t token = *p++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15) literalCount += getLength(p, end);
+        if (static_cast<size_t>(end - p) < literalCount || out.size() - base + literalCount > rawSize) {
+            throw std::runtime_error("corrupt compressed block");
+        }
+        out.insert(out.end(), p, p + literalCount);
+        p += literalCount;
+        if (p == end) break;  // последняя последовательность - без совпадения
+
+        if (end - p < 2) throw std::runtime_error("corrupt compressed block");
+        const size_t offset = p[0] | static_cast<size_t>(p[1]) << 8;
+        p += 2;
+        size_t length = (token & 15u) + MIN_MATCH;
+        if ((token & 15u) == 15) length += getLength(p, end);
+
+        const size_t produced = out.size() - base;
+        if (offset == 0 || offset > produced || produced + length > rawSize) {
+            throw std::runtime_error("corrupt compressed block");
+        }
+        // Совпадение может перекрываться с собой (повтор короткого шаблона)
+        size_t from = out.size() - offset;
+        for (size_t k = 0; k < length; ++k) out.push_back(out[from + k]);
+    }
+    if (out.size() - base != rawSize) throw std::runtime_error("corrupt compressed block");
+}
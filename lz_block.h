@@ -0,0 +1,24 @@
+#ifndef LZ_BLOCK_H
+#define LZ_BLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Сжатие блоков журнала в духе LZ4: последовательности
+//
+//   токен | длина литералов сверх 15 | литералы | u16 смещение | длина совпадения сверх 19
+//
+// Старшие 4 бита токена - число литералов, младшие - длина совпадения
+// минус 4; 15 означает продолжение байтами по 255. Последняя
+// последовательность - только литералы. Совпадения ищутся хешем 4 байт
+// без цепочек: сжатие быстрое и однопроходное, фоновому потоку журнала
+// этого хватает с запасом.
+
+// Сжатый блок дописывается в out
+void lzCompress(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+// Распаковка ровно в rawSize байт; порча данных - std::runtime_error
+void lzDecompress(const uint8_t* data, size_t size, size_t rawSize, std::vector<uint8_t>& out);
+
+#endif
@@ -1,18 +1,277 @@
+#include <algorithm>
 #include <iostream>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "game.h"
+#include "cluster.h"
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
-int main() {
+struct Options {
+    GameConfig config;
+    bool headless = false;
+    uint64_t ticks = 1000;
+    std::string savePath;
+    int clusterShards = 0;       // > 0 - игра кластером процессов
+    std::string clusterSocket;
+    bool clusterExternal = false;  // шарды запускаются вручную (--shard-node)
+    std::string shardNodeSocket;   // этот процесс - шард кластера
+};
+
+static void printUsage() {
+    std::cout << "Usage: lab07 [options]\n"
+              << "  --headless            run without sleeps and display, print report\n"
+              << "  --ticks N             ticks to simulate in headless mode (1000)\n"
+              << "  --npcs N              number of NPCs (50)\n"
+              << "  --map WxH             map size (100x100)\n"
+              << "  --seed S              master seed, 0 - random (0)\n"
+              << "  --broadphase NAME     brute | grid | verlet | sharded (grid)\n"
+              << "  --shards N            map strips for sharded broadphase, 0 - cores (0)\n"
+              << "  --battles MODE        rounds | pool (rounds)\n"
+              << "  --battle-workers N    battle threads in pool mode (4)\n"
+              << "  --compact RATIO       drop dead NPCs when this share is dead, 0 - never (0.25)\n"
+              << "  --duration S          real-time mode length in seconds (30)\n"
+              << "  --display MODE        text | ansi - map frames, ansi redraws changed cells (text);\n"
+              << "                        ansi implies --quiet unless --battle-log is given\n"
+              << "  --fps N               map frames per second in real-time mode (1)\n"
+              << "  --view COLSxROWS      map size in characters (64x20)\n"
+              << "  --battle-log FILE     write battles to FILE instead of stdout\n"
+              << "  --load FILE           start from a saved world snapshot\n"
+              << "  --save FILE           save the final world snapshot to FILE\n"
+              << "  --journal FILE        record moves and battles to a compressed journal\n"
+              << "  --keyframe-every N    journal keyframe period in ticks (100)\n"
+              << "  --replay FILE         replay a journal instead of simulating\n"
+              << "  --replay-from TICK    start the replay at TICK (journal start)\n"
+              << "  --metrics FILE        export metrics to FILE (*.json - JSON, else Prometheus)\n"
+              << "  --metrics-interval MS metrics export period (1000)\n"
+              << "  --quiet               do not log individual battles\n"
+              << "  --cluster N           headless run as a coordinator and N shard processes\n"
+              << "                        (separate model, not comparable to --headless)\n"
+              << "  --cluster-socket PATH coordinator socket (/tmp/lab07-<pid>.sock)\n"
+              << "  --cluster-external    do not spawn shards, wait for --shard-node processes\n"
+              << "  --shard-node PATH     run as a cluster shard connected to PATH\n";
+}
+
+// "WxH" -> width, height
+static void parseSize(const std::string& size, int& width, int& height, const char* what) {
+    size_t sep = size.find('x');
+    if (sep == std::string::npos) {
+        throw std::invalid_argument(std::string(what) + " must look like 100x100");
+    }
+    width = std::stoi(size.substr(0, sep));
+    height = std::stoi(size.substr(sep + 1));
+}
+
+static Options parseArgs(int argc, char* argv[]) {
+    Options options;
+    
+    auto value = [&](int& i) -> std::string {
+        if (i + 1 >= argc) {
+            throw std::invalid_argument(std::string("missing value for ") + argv[i]);
+        }
+        return argv[++i];
+    };
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        
+        if (arg == "--headless") {
+            options.headless = true;
+            options.config.battleLog = LogDestination::DISCARD;
+        } else if (arg == "--ticks") {
+            options.ticks = std::stoull(value(i));
+        } else if (arg == "--npcs") {
+            options.config.npcCount = std::stoi(value(i));
+        } else if (arg == "--map") {
+            parseSize(value(i), options.config.mapX, options.config.mapY, "map size");
+        } else if (arg == "--seed") {
+            options.config.seed = std::stoull(value(i));
+        } else if (arg == "--broadphase") {
+            std::string name = value(i);
+            if (name == "brute") {
+                options.config.broadphase = BroadphaseKind::BRUTE_FORCE;
+            } else if (name == "grid") {
+                options.config.broadphase = BroadphaseKind::UNIFORM_GRID;
+            } else if (name == "verlet") {
+                options.config.broadphase = BroadphaseKind::VERLET;
+            } else if (name == "sharded") {
+                options.config.broadphase = BroadphaseKind::SHARDED;
+            } else {
+                throw std::invalid_argument("unknown broadphase: " + name);
+            }
+        } else if (arg == "--shards") {
+            options.config.shards = std::stoi(value(i));
+        } else if (arg == "--battles") {
+            std::string mode = value(i);
+            if (mode == "rounds") {
+                options.config.battleScheduler = BattleScheduler::ROUNDS;
+            } else if (mode == "pool") {
+                options.config.battleScheduler = BattleScheduler::POOL;
+            } else {
+                throw std::invalid_argument("unknown battle mode: " + mode);
+            }
+        } else if (arg == "--battle-workers") {
+            options.config.battleWorkers = std::stoi(value(i));
+        } else if (arg == "--compact") {
+            options.config.compactDeadRatio = std::stod(value(i));
+        } else if (arg == "--duration") {
+            options.config.durationSeconds = std::stoi(value(i));
+        } else if (arg == "--display") {
+            std::string mode = value(i);
+            if (mode == "text") {
+                options.config.mapStyle = MapStyle::TEXT;
+            } else if (mode == "ansi") {
+                options.config.mapStyle = MapStyle::ANSI;
+            } else {
+                throw std::invalid_argument("unknown display mode: " + mode);
+            }
+        } else if (arg == "--fps") {
+            options.config.displayMillis = std::max(1, 1000 / std::max(1, std::stoi(value(i))));
+        } else if (arg == "--view") {
+            parseSize(value(i), options.config.viewCols, options.config.viewRows, "view size");
+        } else if (arg == "--battle-log") {
+            options.config.battleLog = LogDestination::FILE;
+            options.config.battleLogPath = value(i);
+        } else if (arg == "--load") {
+            options.config.loadPath = value(i);
+        } else if (arg == "--save") {
+            options.savePath = value(i);
+        } else if (arg == "--journal") {
+            options.config.journalPath = value(i);
+        } else if (arg == "--keyframe-every") {
+            options.config.keyframeTicks = std::stoi(value(i));
+        } else if (arg == "--replay") {
+            options.config.replayPath = value(i);
+        } else if (arg == "--replay-from") {
+            options.config.replayFrom = std::stoull(value(i));
+        } else if (arg == "--metrics") {
+            options.config.metricsPath = value(i);
+            const std::string& path = options.config.metricsPath;
+            bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+            options.config.metricsFormat = json ? MetricsFormat::JSON : MetricsFormat::PROMETHEUS;
+        } else if (arg == "--metrics-interval") {
+            options.config.metricsMillis = std::stoi(value(i));
+        } else if (arg == "--cluster") {
+            options.clusterShards = std::stoi(value(i));
+        } else if (arg == "--cluster-socket") {
+            options.clusterSocket = value(i);
+        } else if (arg == "--cluster-external") {
+            options.clusterExternal = true;
+        } else if (arg == "--shard-node") {
+            options.shardNodeSocket = value(i);
+        } else if (arg == "--quiet") {
+            options.config.battleLog = LogDestination::DISCARD;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            std::exit(0);
+        } else {
+            throw std::invalid_argument("unknown option: " + arg);
+        }
+    }
+    
+    if (options.config.npcCount < 0 || options.config.mapX <= 0 || options.config.mapY <= 0) {
+        throw std::invalid_argument("NPC count and map size must be positive");
+    }
+    
+    // ANSI-кадр перерисовывает клетки по адресам и считает экран своим:
+    // бои в stdout прокручивали бы его, поэтому без --battle-log не пишутся
+    if (!options.headless && options.config.mapStyle == MapStyle::ANSI &&
+        options.config.battleLog == LogDestination::STDOUT) {
+        options.config.battleLog = LogDestination::DISCARD;
+    }
+    return options;
+}
+
+// Координатор в этом процессе, шарды - дочерние процессы (или внешние)
+static int runCluster(const Options& options) {
+    ClusterConfig config;
+    config.shards = options.clusterShards;
+    config.npcCount = options.config.npcCount;
+    config.mapX = options.config.mapX;
+    config.mapY = options.config.mapY;
+    config.seed = options.config.seed;
+    config.ticks = options.ticks;
+    config.socketPath = options.clusterSocket;
+#ifndef _WIN32
+    if (config.socketPath.empty()) {
+        config.socketPath = "/tmp/lab07-" + std::to_string(::getpid()) + ".sock";
+    }
+#endif
+    ClusterCoordinator coordinator(config);
+    std::cout << "Cluster: " << config.shards << " shards, " << config.npcCount << " NPCs on "
+              << config.mapX << "x" << config.mapY << " map (seed: " << coordinator.seed()
+              << ", socket: " << config.socketPath << ")" << std::endl;
+
+    std::vector<int> children;
+#ifndef _WIN32
+    if (!options.clusterExternal) {
+        for (int s = 0; s < config.shards; ++s) {
+            pid_t pid = ::fork();
+            if (pid < 0) throw std::runtime_error("fork failed");
+            if (pid == 0) {
+                int code = 0;
+                try {
+                    ClusterShard(config.socketPath).run();
+                } catch (const std::exception& e) {
+                    std::cerr << "Shard error: " << e.what() << "\n";
+                    code = 1;
+                }
+                std::_Exit(code);
+            }
+            children.push_back(pid);
+        }
+    }
+#endif
+
+    ClusterReport report = coordinator.run();
+    printClusterReport(report);
+
+    int failed = 0;
+#ifndef _WIN32
+    for (int pid : children) {
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+    }
+#endif
+    return failed == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+#ifdef _WIN32
     // Устанавливаем кодировку для Windows
     system("chcp 65001 > nul");
+#endif
     
     std::cout << "=== Lab 7: Multi-threaded NPC Game ===\n";
-    std::cout << "Running for 10 seconds (test version)...\n\n";
     
     try {
-        Game game;
+        Options options = parseArgs(argc, argv);
+        if (!options.shardNodeSocket.empty()) {
+            ClusterShard(options.shardNodeSocket).run();
+            return 0;
+        }
+        if (options.clusterShards > 0) {
+            return runCluster(options);
+        }
+        
+        Game game(options.config);
+        
+        if (options.headless) {
+            // Без пауз и без отображения: сколько тиков в секунду выдает машина
+            game.printReport(game.runHeadless(options.ticks));
+        } else {
+            game.start();
+        }
         
-        // Вместо вызова start(), запустим вручную на 10 секунд
-        game.start();
+        if (!options.savePath.empty()) {
+            uint64_t tick = game.saveSnapshot(options.savePath);
+            std::cout << "World saved to " << options.savePath << " (tick " << tick << ")\n";
+        }
         
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
@@ -0,0 +1,163 @@
+#include "map_renderer.h"
+#include "kill_kernel.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// Цвета типов из 256-цветной палитры терминала
+constexpr int TYPE_COLORS[NPC_TYPE_COUNT] = {
+    34, 130, 28, 250, 120, 196, 94, 178, 99, 213, 64, 166, 231, 180, 139, 160,
+};
+
+void appendCursor(std::string& out, int row, int col) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "\x1b[%d;%dH", row + 1, col + 1);
+    out += buf;
+}
+
+void appendColor(std::string& out, uint8_t color, uint8_t mixed) {
+    if (color == 0) {
+        out += "\x1b[0m";
+    } else if (color == mixed) {
+        out += "\x1b[0;1;97m";
+    } else {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "\x1b[0;38;5;%dm", TYPE_COLORS[color - 1]);
+        out += buf;
+    }
+}
+
+}
+
+MapRenderer::MapRenderer(int cols, int rows, MapStyle style)
+    : cols(std::max(cols, 1)), rows(std::max(rows, 1)), style(style) {
+    screenWidth = std::max(this->cols + 2, 3 * LEGEND_ENTRY);
+    legendPerLine = std::max(1, screenWidth / LEGEND_ENTRY);
+    const int legendLines =
+        static_cast<int>((NPC_TYPE_COUNT + legendPerLine - 1) / legendPerLine);
+    // Заголовок, счетчики, рамка сверху, карта, рамка снизу, легенда
+    screenHeight = 2 + 1 + this->rows + 1 + legendLines;
+    screen.assign(static_cast<size_t>(screenWidth) * screenHeight, Cell{});
+    next = screen;
+}
+
+char MapRenderer::cellSymbol(uint16_t types) {
+    if (types == 0) return '.';
+    if (types & (types - 1)) return '*';
+    return NPC_TRAITS[lowestBit(types)].symbol;
+}
+
+void MapRenderer::put(int row, int col, const std::string& text) {
+    Cell* line = &next[static_cast<size_t>(row) * screenWidth];
+    for (size_t k = 0; k < text.size() && col + static_cast<int>(k) < screenWidth; ++k) {
+        line[col + k] = Cell{text[k], 0};
+    }
+}
+
+void MapRenderer::compose(const WorldSnapshot& snap, const MapStatus& status) {
+    std::fill(next.begin(), next.end(), Cell{});
+    char buf[128];
+
+    std::snprintf(buf, sizeof(buf), "=== MAP %dx%d (tick %llu) ===", snap.mapX, snap.mapY,
+                  static_cast<unsigned long long>(status.tick));
+    put(0, 0, buf);
+    std::snprintf(buf, sizeof(buf), "Alive: %zu  Dead: %zu  Battles: %llu", status.alive,
+                  status.dead, static_cast<unsigned long long>(status.battles));
+    put(1, 0, buf);
+
+    const std::string border = "+" + std::string(cols, '-') + "+";
+    put(2, 0, border);
+    put(3 + rows, 0, border);
+
+    const bool hasGrid = snap.gridCols == cols && snap.gridRows == rows;
+    for (int r = 0; r < rows; ++r) {
+        Cell* line = &next[static_cast<size_t>(3 + r) * screenWidth];
+        line[0] = Cell{'|', 0};
+        line[cols + 1] = Cell{'|', 0};
+        for (int c = 0; c < cols; ++c) {
+            const uint16_t types = hasGrid ? snap.grid[static_cast<size_t>(r) * cols + c] : 0;
+            uint8_t color = 0;
+            if (types & (types - 1)) {
+                color = MIXED;
+            } else if (types) {
+                color = static_cast<uint8_t>(lowestBit(types) + 1);
+            }
+            line[c + 1] = Cell{cellSymbol(types), color};
+        }
+    }
+
+    // Легенда: место каждого типа постоянно, меняются только числа
+    const int legendRow = 4 + rows;
+    for (size_t t = 0; t < NPC_TYPE_COUNT; ++t) {
+        const int row = legendRow + static_cast<int>(t) / legendPerLine;
+        const int col = static_cast<int>(t) % legendPerLine * LEGEND_ENTRY;
+        std::snprintf(buf, sizeof(buf), "%c %-9s%7zu", NPC_TRAITS[t].symbol,
+                      NPC_TRAITS[t].name, status.aliveByType[t]);
+        put(row, col, buf);
+        next[static_cast<size_t>(row) * screenWidth + col].color = static_cast<uint8_t>(t + 1);
+    }
+}
+
+std::string MapRenderer::render(const WorldSnapshot& snap, const MapStatus& status) {
+    compose(snap, status);
+
+    changed = 0;
+    for (size_t i = 0; i < next.size(); ++i) {
+        if (!drawn || next[i] != screen[i]) changed++;
+    }
+
+    std::string out;
+    if (style == MapStyle::ANSI) {
+        emitAnsi(out);
+    } else {
+        emitText(out);
+    }
+    screen.swap(next);
+    drawn = true;
+    return out;
+}
+
+void MapRenderer::emitText(std::string& out) const {
+    out.reserve(out.size() + next.size() + screenHeight);
+    for (int r = 0; r < screenHeight; ++r) {
+        const Cell* line = &next[static_cast<size_t>(r) * screenWidth];
+        int end = screenWidth;
+        while (end > 0 && line[end - 1].ch == ' ') end--;
+        for (int c = 0; c < end; ++c) out += line[c].ch;
+        out += '\n';
+    }
+}
+
+void MapRenderer::emitAnsi(std::string& out) const {
+    // Первый кадр: экран очищается, дальше сравнение с пустым экраном
+    const Cell blank{};
+    if (!drawn) out += "\x1b[H\x1b[2J";
+    auto before = [&](size_t i) { return drawn ? screen[i] : blank; };
+
+    for (int r = 0; r < screenHeight; ++r) {
+        const size_t base = static_cast<size_t>(r) * screenWidth;
+        int c = 0;
+        while (c < screenWidth) {
+            if (next[base + c] == before(base + c)) {
+                c++;
+                continue;
+            }
+
+            // Отрезок изменившихся клеток одним переходом курсора
+            appendCursor(out, r, c);
+            uint8_t color = 0;
+            for (; c < screenWidth && next[base + c] != before(base + c); ++c) {
+                const Cell& cell = next[base + c];
+                if (cell.color != color) {
+                    appendColor(out, cell.color, MIXED);
+                    color = cell.color;
+                }
+                out += cell.ch;
+            }
+            if (color != 0) out += "\x1b[0m";
+        }
+    }
+    // Курсор под картой: остальной вывод не затирает кадр
+    appendCursor(out, screenHeight, 0);
+}
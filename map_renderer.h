@@ -0,0 +1,76 @@
+#ifndef MAP_RENDERER_H
+#define MAP_RENDERER_H
+
+#include "npc.h"
+#include "snapshot.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Строки над картой: счетчики игры на момент кадра
+struct MapStatus {
+    uint64_t tick = 0;
+    size_t alive = 0;
+    size_t dead = 0;
+    uint64_t battles = 0;
+    std::array<size_t, NPC_TYPE_COUNT> aliveByType{};
+};
+
+enum class MapStyle {
+    TEXT,  // кадр целиком обычным текстом (файл, канал)
+    ANSI   // терминал: выводятся только изменившиеся клетки
+};
+
+// Вывод карты для displayWorker. Кадр - неизменная по размеру сетка
+// символов: заголовок, счетчики, карта из WorldSnapshot::grid и легенда
+// по типам. Стоимость кадра зависит только от размера сетки, а не от
+// числа NPC. В ANSI прошлый кадр хранится, и в вывод попадают только
+// отличающиеся клетки - курсор переводится к началу каждого их отрезка.
+class MapRenderer {
+public:
+    MapRenderer(int cols, int rows, MapStyle style);
+
+    // Следующий кадр; снимок должен быть с картой cols x rows
+    std::string render(const WorldSnapshot& snap, const MapStatus& status);
+
+    // Клеток, отличавшихся от прошлого кадра, в последнем render
+    size_t changedCells() const { return changed; }
+
+    int width() const { return screenWidth; }
+    int height() const { return screenHeight; }
+
+    // Символ клетки карты по маске типов ('.' - пусто, '*' - разные типы)
+    static char cellSymbol(uint16_t types);
+
+private:
+    // color: 0 - по умолчанию, 1..NPC_TYPE_COUNT - тип + 1, MIXED - разные
+    struct Cell {
+        char ch = ' ';
+        uint8_t color = 0;
+
+        bool operator==(const Cell& other) const { return ch == other.ch && color == other.color; }
+        bool operator!=(const Cell& other) const { return !(*this == other); }
+    };
+    static constexpr uint8_t MIXED = NPC_TYPE_COUNT + 1;
+    static constexpr int LEGEND_ENTRY = 20;  // "O Orc      1234567 "
+
+    const int cols;
+    const int rows;
+    const MapStyle style;
+    int screenWidth;
+    int screenHeight;
+    int legendPerLine;
+
+    std::vector<Cell> screen;  // выведенный кадр
+    std::vector<Cell> next;
+    bool drawn = false;
+    size_t changed = 0;
+
+    void put(int row, int col, const std::string& text);
+    void compose(const WorldSnapshot& snap, const MapStatus& status);
+    void emitText(std::string& out) const;
+    void emitAnsi(std::string& out) const;
+};
+
+#endif
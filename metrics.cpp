@@ -0,0 +1,284 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+std::atomic<uint64_t> nextMetricsId{1};
+
+// Блоки текущего потока для каждого реестра, в который он писал
+thread_local std::vector<std::pair<uint64_t, ThreadMetrics*>> threadBlocks;
+
+constexpr const char* COUNTER_NAMES[COUNTER_COUNT] = {
+    "ticks_total",
+    "pairs_tested_total",
+    "pairs_found_total",
+    "battles_enqueued_total",
+    "battles_resolved_total",
+    "display_frames_total",
+};
+
+constexpr const char* HISTOGRAM_NAMES[HISTOGRAM_COUNT] = {
+    "tick_seconds",
+    "move_seconds",
+    "detect_seconds",
+    "battles_seconds",
+    "battle_seconds",
+    "display_seconds",
+    "npcs_lock_wait_seconds",
+    "cout_lock_wait_seconds",
+    "battle_queue_depth",
+};
+
+constexpr double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+int highestBit(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int bit = 0;
+    while (v >>= 1) bit++;
+    return bit;
+#endif
+}
+
+}
+
+const char* counterName(CounterId id) {
+    return COUNTER_NAMES[static_cast<size_t>(id)];
+}
+
+const char* histogramName(HistogramId id) {
+    return HISTOGRAM_NAMES[static_cast<size_t>(id)];
+}
+
+bool isDuration(HistogramId id) {
+    return id != HistogramId::QUEUE_DEPTH;
+}
+
+size_t Histogram::bucketOf(uint64_t value) {
+    if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+    const int bit = highestBit(value);
+    if (bit >= MAX_BITS) return BUCKETS - 1;
+    const size_t group = static_cast<size_t>(bit - SUB_BITS + 1);
+    const size_t sub = static_cast<size_t>((value >> (bit - SUB_BITS)) - SUB_BUCKETS);
+    return group * SUB_BUCKETS + sub;
+}
+
+uint64_t Histogram::bucketHigh(size_t bucket) {
+    const size_t group = bucket / SUB_BUCKETS;
+    const uint64_t sub = bucket % SUB_BUCKETS;
+    if (group == 0) return sub;
+    const int shift = static_cast<int>(group) - 1;
+    return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    buckets[bucketOf(value)]++;
+    total++;
+    valueSum += value;
+    valueMax = std::max(valueMax, value);
+}
+
+void Histogram::merge(const Histogram& other) {
+    for (size_t b = 0; b < BUCKETS; ++b) buckets[b] += other.buckets[b];
+    total += other.total;
+    valueSum += other.valueSum;
+    valueMax = std::max(valueMax, other.valueMax);
+}
+
+uint64_t Histogram::percentile(double q) const {
+    if (total == 0) return 0;
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * total)));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return std::min(bucketHigh(b), valueMax);
+    }
+    return valueMax;
+}
+
+void AtomicHistogram::addTo(Histogram& out) const {
+    for (size_t b = 0; b < Histogram::BUCKETS; ++b) {
+        out.buckets[b] += buckets[b].load(std::memory_order_relaxed);
+    }
+    out.total += total.load(std::memory_order_relaxed);
+    out.valueSum += valueSum.load(std::memory_order_relaxed);
+    out.valueMax = std::max(out.valueMax, valueMax.load(std::memory_order_relaxed));
+}
+
+const RoleMetrics* MetricsSnapshot::find(const std::string& role) const {
+    for (const RoleMetrics& r : roles) {
+        if (r.role == role) return &r;
+    }
+    return nullptr;
+}
+
+Metrics::Metrics() : id(nextMetricsId++) {}
+
+ThreadMetrics& Metrics::local(const char* role) {
+    for (const auto& entry : threadBlocks) {
+        if (entry.first == id) return *entry.second;
+    }
+
+    auto block = std::make_unique<ThreadMetrics>(role);
+    ThreadMetrics* raw = block.get();
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        threads.push_back(std::move(block));
+    }
+    threadBlocks.emplace_back(id, raw);
+    return *raw;
+}
+
+MetricsSnapshot Metrics::snapshot() const {
+    MetricsSnapshot snap;
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    for (const auto& thread : threads) {
+        auto it = std::find_if(snap.roles.begin(), snap.roles.end(),
+                               [&](const RoleMetrics& r) { return r.role == thread->role; });
+        if (it == snap.roles.end()) {
+            snap.roles.emplace_back();
+            snap.roles.back().role = thread->role;
+            it = snap.roles.end() - 1;
+        }
+        it->threads++;
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+            it->counters[c] += thread->counters[c].load(std::memory_order_relaxed);
+        }
+        for (size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+            thread->histograms[h].addTo(it->histograms[h]);
+        }
+    }
+    return snap;
+}
+
+// Наносекунды экспортируются в секундах, глубина очереди - как есть
+static double exported(HistogramId id, uint64_t value) {
+    return isDuration(id) ? value * 1e-9 : static_cast<double>(value);
+}
+
+static void formatPrometheus(std::ostream& out, const MetricsSnapshot& snap) {
+    for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+        const std::string name = std::string("lab07_") + COUNTER_NAMES[c];
+        out << "# TYPE " << name << " counter\n";
+        for (const RoleMetrics& r : snap.roles) {
+            out << name << "{role=\"" << r.role << "\"} " << r.counters[c] << "\n";
+        }
+    }
+    for (size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+        const HistogramId id = static_cast<HistogramId>(h);
+        const std::string name = std::string("lab07_") + HISTOGRAM_NAMES[h];
+        out << "# TYPE " << name << " summary\n";
+        for (const RoleMetrics& r : snap.roles) {
+            const Histogram& hist = r.histograms[h];
+            if (hist.count() == 0) continue;
+            for (double q : QUANTILES) {
+                out << name << "{role=\"" << r.role << "\",quantile=\"" << q << "\"} "
+                    << exported(id, hist.percentile(q)) << "\n";
+            }
+            out << name << "_sum{role=\"" << r.role << "\"} " << exported(id, hist.sum()) << "\n";
+            out << name << "_count{role=\"" << r.role << "\"} " << hist.count() << "\n";
+        }
+    }
+    out << "# TYPE lab07_threads gauge\n";
+    for (const RoleMetrics& r : snap.roles) {
+        out << "lab07_threads{role=\"" << r.role << "\"} " << r.threads << "\n";
+    }
+}
+
+static void formatJson(std::ostream& out, const MetricsSnapshot& snap) {
+    out << "{\"roles\":[";
+    for (size_t i = 0; i < snap.roles.size(); ++i) {
+        const RoleMetrics& r = snap.roles[i];
+        out << (i ? "," : "") << "\n {\"role\":\"" << r.role << "\",\"threads\":" << r.threads
+            << ",\"counters\":{";
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+            out << (c ? "," : "") << "\"" << COUNTER_NAMES[c] << "\":" << r.counters[c];
+        }
+        out << "},\"histograms\":{";
+        bool first = true;
+        for (size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+            const HistogramId id = static_cast<HistogramId>(h);
+            const Histogram& hist = r.histograms[h];
+            if (hist.count() == 0) continue;
+            out << (first ? "" : ",") << "\"" << HISTOGRAM_NAMES[h] << "\":{\"count\":"
+                << hist.count() << ",\"sum\":" << exported(id, hist.sum())
+                << ",\"p50\":" << exported(id, hist.percentile(0.5))
+                << ",\"p90\":" << exported(id, hist.percentile(0.9))
+                << ",\"p99\":" << exported(id, hist.percentile(0.99))
+                << ",\"p999\":" << exported(id, hist.percentile(0.999))
+                << ",\"max\":" << exported(id, hist.max()) << "}";
+            first = false;
+        }
+        out << "}}";
+    }
+    out << "\n]}\n";
+}
+
+std::string Metrics::format(const MetricsSnapshot& snapshot, MetricsFormat format) {
+    std::ostringstream out;
+    out.precision(9);
+    if (format == MetricsFormat::JSON) {
+        formatJson(out, snapshot);
+    } else {
+        formatPrometheus(out, snapshot);
+    }
+    return out.str();
+}
+
+MetricsExporter::MetricsExporter(const Metrics& metrics, std::string path,
+                                 MetricsFormat format, int intervalMillis)
+    : metrics(metrics), path(std::move(path)), format(format),
+      intervalMillis(std::max(intervalMillis, 1)) {
+    writer = std::thread(&MetricsExporter::writerLoop, this);
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::write() {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    const std::string text = Metrics::format(metrics.snapshot(), format);
+
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out) return false;
+        out << text;
+        if (!out) return false;
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());  // rename на Windows не заменяет существующий файл
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) return false;
+    exportCount++;
+    return true;
+}
+
+void MetricsExporter::writerLoop() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (!stopping) {
+        wakeCV.wait_for(lock, std::chrono::milliseconds(intervalMillis));
+        if (stopping) break;
+        lock.unlock();
+        write();
+        lock.lock();
+    }
+}
+
+void MetricsExporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    wakeCV.notify_all();
+    if (writer.joinable()) writer.join();
+
+    write();
+}
@@ -0,0 +1,242 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Счетчики потоков игры
+enum class CounterId {
+    TICKS,
+    PAIRS_TESTED,      // кандидатов проверено поиском пар
+    PAIRS_FOUND,
+    BATTLES_ENQUEUED,  // поставлено в очередь (POOL) или в раунды (ROUNDS)
+    BATTLES_RESOLVED,
+    DISPLAY_FRAMES,
+    COUNT
+};
+
+// Гистограммы: длительности в наносекундах, глубина очереди - в задачах
+enum class HistogramId {
+    TICK,
+    MOVE,
+    DETECT,
+    BATTLES,         // фаза боев тика
+    BATTLE,          // один бой в потоке пула
+    DISPLAY,         // один вывод карты
+    NPCS_LOCK_WAIT,  // ожидание npcsMutex
+    COUT_LOCK_WAIT,  // ожидание coutMutex
+    QUEUE_DEPTH,     // задач в очереди боев после постановки пачки
+    COUNT
+};
+
+constexpr size_t COUNTER_COUNT = static_cast<size_t>(CounterId::COUNT);
+constexpr size_t HISTOGRAM_COUNT = static_cast<size_t>(HistogramId::COUNT);
+
+// Имена для экспорта; durations - значения в наносекундах
+const char* counterName(CounterId id);
+const char* histogramName(HistogramId id);
+bool isDuration(HistogramId id);
+
+// Гистограмма в духе HDR: значения делятся на группы [2^k, 2^(k+1)),
+// каждая группа - на SUB_BUCKETS равных корзин. Относительная ошибка
+// квантиля не больше 1/SUB_BUCKETS при постоянной памяти и O(1) записи.
+class Histogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BITS;
+    static constexpr int MAX_BITS = 44;  // до ~4.8 часа в наносекундах
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    static size_t bucketOf(uint64_t value);
+    static uint64_t bucketHigh(size_t bucket);  // наибольшее значение корзины
+
+    void record(uint64_t value);
+    void merge(const Histogram& other);
+
+    uint64_t count() const { return total; }
+    uint64_t sum() const { return valueSum; }
+    uint64_t max() const { return valueMax; }
+    double mean() const { return total ? static_cast<double>(valueSum) / total : 0; }
+
+    // Значение, не меньше которого доля q записей (0 < q <= 1)
+    uint64_t percentile(double q) const;
+
+private:
+    std::array<uint64_t, BUCKETS> buckets{};
+    uint64_t total = 0;
+    uint64_t valueSum = 0;
+    uint64_t valueMax = 0;
+
+    friend class AtomicHistogram;
+};
+
+// Гистограмма одного потока: пишет только владелец (relaxed load/store
+// без блокировок и RMW), экспортер читает в любой момент
+class AtomicHistogram {
+public:
+    void record(uint64_t value) {
+        bump(buckets[Histogram::bucketOf(value)], 1);
+        bump(total, 1);
+        bump(valueSum, value);
+        if (value > valueMax.load(std::memory_order_relaxed)) {
+            valueMax.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    void addTo(Histogram& out) const;
+
+private:
+    std::array<std::atomic<uint64_t>, Histogram::BUCKETS> buckets{};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> valueSum{0};
+    std::atomic<uint64_t> valueMax{0};
+
+    static void bump(std::atomic<uint64_t>& v, uint64_t n) {
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// Метрики одного потока игры
+class ThreadMetrics {
+public:
+    explicit ThreadMetrics(std::string role) : role(std::move(role)) {}
+
+    void add(CounterId id, uint64_t n = 1) {
+        std::atomic<uint64_t>& c = counters[static_cast<size_t>(id)];
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    void record(HistogramId id, uint64_t value) {
+        histograms[static_cast<size_t>(id)].record(value);
+    }
+    void recordDuration(HistogramId id, std::chrono::steady_clock::duration d) {
+        record(id, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+    }
+    void recordSince(HistogramId id, std::chrono::steady_clock::time_point start) {
+        recordDuration(id, std::chrono::steady_clock::now() - start);
+    }
+
+    const std::string role;
+
+private:
+    std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+    std::array<AtomicHistogram, HISTOGRAM_COUNT> histograms;
+
+    friend class Metrics;
+};
+
+// Длительность области видимости в гистограмму
+class ScopedTimer {
+public:
+    ScopedTimer(ThreadMetrics& metrics, HistogramId id)
+        : metrics(metrics), id(id), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { metrics.recordSince(id, start); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    ThreadMetrics& metrics;
+    HistogramId id;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Захват мьютекса с записью времени ожидания
+template <typename Lock, typename Mutex>
+Lock timedLock(Mutex& mutex, ThreadMetrics& metrics, HistogramId id) {
+    auto start = std::chrono::steady_clock::now();
+    Lock lock(mutex);
+    metrics.recordSince(id, start);
+    return lock;
+}
+
+// Сумма по потокам одной роли
+struct RoleMetrics {
+    std::string role;
+    size_t threads = 0;
+    std::array<uint64_t, COUNTER_COUNT> counters{};
+    std::array<Histogram, HISTOGRAM_COUNT> histograms;
+
+    uint64_t counter(CounterId id) const { return counters[static_cast<size_t>(id)]; }
+    const Histogram& histogram(HistogramId id) const {
+        return histograms[static_cast<size_t>(id)];
+    }
+};
+
+struct MetricsSnapshot {
+    std::vector<RoleMetrics> roles;  // в порядке первой регистрации
+
+    const RoleMetrics* find(const std::string& role) const;
+};
+
+enum class MetricsFormat {
+    PROMETHEUS,  // текстовый формат экспозиции Prometheus
+    JSON
+};
+
+// Реестр метрик потоков. Поток получает свой блок при первом local()
+// (как буферы BattleLog) и дальше пишет в него без блокировок.
+class Metrics {
+public:
+    Metrics();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    // Блок текущего потока; role задается при первом вызове из потока
+    ThreadMetrics& local(const char* role);
+
+    MetricsSnapshot snapshot() const;
+
+    static std::string format(const MetricsSnapshot& snapshot, MetricsFormat format);
+
+private:
+    const uint64_t id;
+    mutable std::mutex threadsMutex;
+    std::vector<std::unique_ptr<ThreadMetrics>> threads;
+};
+
+// Периодическая выгрузка метрик в файл: пишется временный файл и
+// переименовывается, поэтому сборщик никогда не читает половину
+class MetricsExporter {
+public:
+    MetricsExporter(const Metrics& metrics, std::string path, MetricsFormat format,
+                    int intervalMillis);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // Синхронная выгрузка; false, если файл не записался
+    bool write();
+
+    // Останавливает поток с финальной выгрузкой
+    void stop();
+
+    uint64_t exports() const { return exportCount; }
+
+private:
+    const Metrics& metrics;
+    const std::string path;
+    const MetricsFormat format;
+    const int intervalMillis;
+
+    std::mutex writeMutex;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCV;
+    bool stopping = false;
+    std::thread writer;
+    std::atomic<uint64_t> exportCount{0};
+
+    void writerLoop();
+};
+
+#endif
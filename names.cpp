@@ -0,0 +1,59 @@
+#include "names.h"
+#include <cstring>
+
+NameId NameTable::intern(const std::string& name) {
+    auto found = index.find(name);
+    if (found != index.end()) return found->second | INTERNED_NAME;
+
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    strings.push_back(name);
+    index.emplace(name, id);
+    return id | INTERNED_NAME;
+}
+
+void NameTable::reserve(size_t count) {
+    strings.reserve(count);
+    index.reserve(count);
+}
+
+NameId encodeName(NameTable& table, NPCType type, const std::string& name) {
+    // "<Тип>_<номер>" без ведущих нулей, номер меньше 2^31
+    const char* prefix = NPC::typeName(type);
+    size_t prefixLength = std::strlen(prefix);
+    size_t digits = name.size() - prefixLength - 1;
+    if (name.size() > prefixLength + 1 && digits <= 10 &&
+        name.compare(0, prefixLength, prefix) == 0 && name[prefixLength] == '_' &&
+        !(name[prefixLength + 1] == '0' && digits > 1)) {
+        uint64_t number = 0;
+        bool numeric = true;
+        for (size_t i = prefixLength + 1; i < name.size() && numeric; ++i) {
+            numeric = name[i] >= '0' && name[i] <= '9';
+            number = number * 10 + static_cast<uint64_t>(name[i] - '0');
+        }
+        if (numeric && number < INTERNED_NAME) return static_cast<NameId>(number);
+    }
+    return table.intern(name);
+}
+
+void appendName(std::string& out, NameId id, NPCType type, const NameTable& table) {
+    if (id & INTERNED_NAME) {
+        out += table.str(id);
+        return;
+    }
+    out += NPC::typeName(type);
+    out += '_';
+
+    char digits[10];
+    int length = 0;
+    do {
+        digits[length++] = static_cast<char>('0' + id % 10);
+        id /= 10;
+    } while (id != 0);
+    while (length > 0) out += digits[--length];
+}
+
+std::string decodeName(NameId id, NPCType type, const NameTable& table) {
+    std::string name;
+    appendName(name, id, type, table);
+    return name;
+}
@@ -0,0 +1,39 @@
+#ifndef NAMES_H
+#define NAMES_H
+
+#include "npc.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Ссылка на имя NPC: 32 бита вместо std::string на каждого.
+// Старший бит 0 - имя вида "<Тип>_<номер>" (как у NPCFactory), в младших
+// битах номер; сама строка не хранится и собирается по запросу.
+// Старший бит 1 - индекс строки в таблице интернирования NameTable.
+using NameId = uint32_t;
+constexpr NameId INTERNED_NAME = 0x80000000u;
+
+// Таблица интернирования произвольных имен: одинаковые имена хранятся один раз
+class NameTable {
+public:
+    NameId intern(const std::string& name);
+    const std::string& str(NameId id) const { return strings[id & ~INTERNED_NAME]; }
+    size_t size() const { return strings.size(); }
+    void reserve(size_t count);
+
+private:
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> index;
+};
+
+// NameId для имени NPC данного типа: сгенерированные имена кодируются
+// номером, остальные интернируются в table
+NameId encodeName(NameTable& table, NPCType type, const std::string& name);
+
+// Дописывает имя в out без временных строк (журнал, вывод карты)
+void appendName(std::string& out, NameId id, NPCType type, const NameTable& table);
+
+std::string decodeName(NameId id, NPCType type, const NameTable& table);
+
+#endif
@@ -5,7 +5,9 @@
 #include <cmath>
 #include <iostream>
 #include <memory>
-#include <random>
+#include <cstdint>
+#include <string_view>
+#include "rng.h"
 
 enum class NPCType {
     ORC,
@@ -27,6 +29,104 @@ enum class NPCType {
     UNKNOWN
 };
 
+// Число настоящих типов (без UNKNOWN)
+constexpr size_t NPC_TYPE_COUNT = static_cast<size_t>(NPCType::UNKNOWN);
+
+// Свойства типа NPC. Единственное место, где они заданы: конструкторы,
+// имена и разбор строк берут их отсюда.
+struct NPCTraits {
+    const char* name;
+    int health;
+    int moveDistance;
+    int killDistance;
+    char symbol;  // клетка карты в displayWorker
+};
+
+// Индекс - NPCType; последняя строка - UNKNOWN
+constexpr NPCTraits NPC_TRAITS[NPC_TYPE_COUNT + 1] = {
+    {"Orc", 100, 20, 10, 'O'},
+    {"Squirrel", 30, 5, 5, 's'},
+    {"Druid", 80, 10, 10, 'd'},
+    {"Knight", 120, 30, 10, 'K'},
+    {"Elf", 70, 10, 50, 'E'},
+    {"Dragon", 200, 50, 30, 'D'},
+    {"Bear", 150, 5, 10, 'B'},
+    {"Bandit", 90, 10, 10, 'b'},
+    {"Werewolf", 110, 40, 5, 'W'},
+    {"Princess", 40, 1, 1, 'P'},
+    {"Toad", 20, 1, 10, 't'},
+    {"Slaver", 85, 10, 10, 'S'},
+    {"Pegasus", 95, 30, 10, 'p'},
+    {"Bittern", 35, 50, 10, 'i'},
+    {"Desman", 25, 5, 20, 'm'},
+    {"Bull", 130, 30, 10, 'u'},
+    {"Unknown", 0, 0, 0, '?'},
+};
+
+constexpr const NPCTraits& traitsOf(NPCType type) {
+    return NPC_TRAITS[static_cast<size_t>(type) <= NPC_TYPE_COUNT
+                      ? static_cast<size_t>(type) : NPC_TYPE_COUNT];
+}
+
+// Совершенный хеш имен типов, подобранный при компиляции: имя -> слот
+// таблицы без коллизий, поэтому разбор - один хеш и одно сравнение.
+namespace npc_type_hash {
+
+constexpr size_t SLOTS = 64;
+
+constexpr uint32_t hash(std::string_view text, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (char c : text) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+constexpr bool collisionFree(uint32_t seed) {
+    bool used[SLOTS] = {};
+    for (size_t t = 0; t < NPC_TYPE_COUNT; ++t) {
+        size_t slot = hash(NPC_TRAITS[t].name, seed) % SLOTS;
+        if (used[slot]) return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t findSeed() {
+    uint32_t seed = 0;
+    while (!collisionFree(seed)) ++seed;
+    return seed;
+}
+
+constexpr uint32_t SEED = findSeed();
+
+struct Table {
+    int8_t slot[SLOTS];
+};
+
+constexpr Table buildTable() {
+    Table table{};
+    for (size_t i = 0; i < SLOTS; ++i) table.slot[i] = -1;
+    for (size_t t = 0; t < NPC_TYPE_COUNT; ++t) {
+        table.slot[hash(NPC_TRAITS[t].name, SEED) % SLOTS] = static_cast<int8_t>(t);
+    }
+    return table;
+}
+
+constexpr Table TABLE = buildTable();
+
+constexpr NPCType lookup(std::string_view text) {
+    int8_t t = TABLE.slot[hash(text, SEED) % SLOTS];
+    return t >= 0 && text == NPC_TRAITS[t].name ? static_cast<NPCType>(t) : NPCType::UNKNOWN;
+}
+
+static_assert(lookup("Dragon") == NPCType::DRAGON, "type hash is broken");
+static_assert(lookup("Bull") == NPCType::BULL, "type hash is broken");
+static_assert(lookup("Dragons") == NPCType::UNKNOWN, "type hash is broken");
+
+}
+
 // Базовый класс NPC
 class NPC {
 protected:
@@ -48,9 +148,11 @@ public:
     virtual ~NPC() = default;
     
     // Getters
-    std::string getName() const { return name; }
+    const std::string& getName() const { return name; }
     NPCType getType() const { return type; }
-    std::string getTypeString() const;
+    std::string getTypeString() const { return typeToString(type); }
+    static std::string typeToString(NPCType type);
+    static const char* typeName(NPCType type);  // без выделения памяти
     int getX() const { return x; }
     int getY() const { return y; }
     int getHealth() const { return health; }
@@ -77,19 +179,32 @@ public:
         health = 0; 
     }
     
+    // Квадрат расстояния в целых числах - для сравнений без sqrt
+    long long squaredDistanceTo(const NPC& other) const {
+        long long dx = static_cast<long long>(x) - other.x;
+        long long dy = static_cast<long long>(y) - other.y;
+        return dx * dx + dy * dy;
+    }
+    
     double distanceTo(const NPC& other) const {
-        return std::sqrt(std::pow(x - other.x, 2) + std::pow(y - other.y, 2));
+        return std::sqrt(static_cast<double>(squaredDistanceTo(other)));
     }
     
-    virtual void move(int maxX, int maxY) {
+    void move(int maxX, int maxY) {
         if (!alive) return;
-        
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(-moveDistance, moveDistance);
-        
-        int newX = x + dis(gen);
-        int newY = y + dis(gen);
+        step(x, y, moveDistance, maxX, maxY);
+    }
+    
+    // Случайный шаг на moveDistance с учетом границ карты
+    // (используется и объектами NPC, и хранилищем World)
+    static void step(int& x, int& y, int moveDistance, int maxX, int maxY) {
+        step(x, y, moveDistance, maxX, maxY, Rng::local());
+    }
+    
+    static void step(int& x, int& y, int moveDistance, int maxX, int maxY,
+                     Xoshiro256& gen) {
+        int newX = x + gen.uniform(-moveDistance, moveDistance);
+        int newY = y + gen.uniform(-moveDistance, moveDistance);
         
         // Проверка границ карты
         if (newX < 0) newX = 0;
@@ -102,7 +217,8 @@ public:
     }
     
     bool canKill(const NPC& other) const {
-        return distanceTo(other) <= killDistance;
+        return squaredDistanceTo(other) <= 
+               static_cast<long long>(killDistance) * killDistance;
     }
     
     virtual std::string toString() const {
@@ -114,122 +230,48 @@ public:
                (alive ? " ALIVE" : " DEAD");
     }
     
-    static NPCType stringToType(const std::string& typeStr) {
-        if (typeStr == "Orc") return NPCType::ORC;
-        if (typeStr == "Squirrel") return NPCType::SQUIRREL;
-        if (typeStr == "Druid") return NPCType::DRUID;
-        if (typeStr == "Knight") return NPCType::KNIGHT;
-        if (typeStr == "Elf") return NPCType::ELF;
-        if (typeStr == "Dragon") return NPCType::DRAGON;
-        if (typeStr == "Bear") return NPCType::BEAR;
-        if (typeStr == "Bandit") return NPCType::BANDIT;
-        if (typeStr == "Werewolf") return NPCType::WEREWOLF;
-        if (typeStr == "Princess") return NPCType::PRINCESS;
-        if (typeStr == "Toad") return NPCType::TOAD;
-        if (typeStr == "Slaver") return NPCType::SLAVER;
-        if (typeStr == "Pegasus") return NPCType::PEGASUS;
-        if (typeStr == "Bittern") return NPCType::BITTERN;
-        if (typeStr == "Desman") return NPCType::DESMAN;
-        if (typeStr == "Bull") return NPCType::BULL;
-        return NPCType::UNKNOWN;
+    static constexpr NPCType stringToType(std::string_view typeStr) {
+        return npc_type_hash::lookup(typeStr);
     }
 };
 
-// Конкретные классы NPC
-class Orc : public NPC {
-public:
-    Orc(const std::string& name, int x, int y)
-        : NPC(name, NPCType::ORC, x, y, 100, 20, 10) {}
-};
-
-class Squirrel : public NPC {
-public:
-    Squirrel(const std::string& name, int x, int y)
-        : NPC(name, NPCType::SQUIRREL, x, y, 30, 5, 5) {}
-};
-
-class Druid : public NPC {
-public:
-    Druid(const std::string& name, int x, int y)
-        : NPC(name, NPCType::DRUID, x, y, 80, 10, 10) {}
-};
-
-class Knight : public NPC {
+// Конкретные типы NPC отличаются только константами из NPC_TRAITS,
+// поэтому это одна шаблонная реализация. move и canKill здесь не
+// виртуальные: берут дальности из таблицы на этапе компиляции.
+template <NPCType T>
+class TypedNPC : public NPC {
 public:
-    Knight(const std::string& name, int x, int y)
-        : NPC(name, NPCType::KNIGHT, x, y, 120, 30, 10) {}
-};
-
-class Elf : public NPC {
-public:
-    Elf(const std::string& name, int x, int y)
-        : NPC(name, NPCType::ELF, x, y, 70, 10, 50) {}
-};
-
-class Dragon : public NPC {
-public:
-    Dragon(const std::string& name, int x, int y)
-        : NPC(name, NPCType::DRAGON, x, y, 200, 50, 30) {}
-};
-
-class Bear : public NPC {
-public:
-    Bear(const std::string& name, int x, int y)
-        : NPC(name, NPCType::BEAR, x, y, 150, 5, 10) {}
-};
-
-class Bandit : public NPC {
-public:
-    Bandit(const std::string& name, int x, int y)
-        : NPC(name, NPCType::BANDIT, x, y, 90, 10, 10) {}
-};
-
-class Werewolf : public NPC {
-public:
-    Werewolf(const std::string& name, int x, int y)
-        : NPC(name, NPCType::WEREWOLF, x, y, 110, 40, 5) {}
-};
-
-class Princess : public NPC {
-public:
-    Princess(const std::string& name, int x, int y)
-        : NPC(name, NPCType::PRINCESS, x, y, 40, 1, 1) {}
-};
-
-class Toad : public NPC {
-public:
-    Toad(const std::string& name, int x, int y)
-        : NPC(name, NPCType::TOAD, x, y, 20, 1, 10) {}
-};
-
-class Slaver : public NPC {
-public:
-    Slaver(const std::string& name, int x, int y)
-        : NPC(name, NPCType::SLAVER, x, y, 85, 10, 10) {}
-};
-
-class Pegasus : public NPC {
-public:
-    Pegasus(const std::string& name, int x, int y)
-        : NPC(name, NPCType::PEGASUS, x, y, 95, 30, 10) {}
-};
-
-class Bittern : public NPC {
-public:
-    Bittern(const std::string& name, int x, int y)
-        : NPC(name, NPCType::BITTERN, x, y, 35, 50, 10) {}
-};
-
-class Desman : public NPC {
-public:
-    Desman(const std::string& name, int x, int y)
-        : NPC(name, NPCType::DESMAN, x, y, 25, 5, 20) {}
+    static constexpr NPCTraits traits = traitsOf(T);
+    
+    TypedNPC(const std::string& name, int x, int y)
+        : NPC(name, T, x, y, traits.health, traits.moveDistance, traits.killDistance) {}
+    
+    void move(int maxX, int maxY) {
+        if (!alive) return;
+        step(x, y, traits.moveDistance, maxX, maxY);
+    }
+    
+    bool canKill(const NPC& other) const {
+        return squaredDistanceTo(other) <=
+               static_cast<long long>(traits.killDistance) * traits.killDistance;
+    }
 };
 
-class Bull : public NPC {
-public:
-    Bull(const std::string& name, int x, int y)
-        : NPC(name, NPCType::BULL, x, y, 130, 30, 10) {}
-};
+using Orc = TypedNPC<NPCType::ORC>;
+using Squirrel = TypedNPC<NPCType::SQUIRREL>;
+using Druid = TypedNPC<NPCType::DRUID>;
+using Knight = TypedNPC<NPCType::KNIGHT>;
+using Elf = TypedNPC<NPCType::ELF>;
+using Dragon = TypedNPC<NPCType::DRAGON>;
+using Bear = TypedNPC<NPCType::BEAR>;
+using Bandit = TypedNPC<NPCType::BANDIT>;
+using Werewolf = TypedNPC<NPCType::WEREWOLF>;
+using Princess = TypedNPC<NPCType::PRINCESS>;
+using Toad = TypedNPC<NPCType::TOAD>;
+using Slaver = TypedNPC<NPCType::SLAVER>;
+using Pegasus = TypedNPC<NPCType::PEGASUS>;
+using Bittern = TypedNPC<NPCType::BITTERN>;
+using Desman = TypedNPC<NPCType::DESMAN>;
+using Bull = TypedNPC<NPCType::BULL>;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,123 @@
+#ifndef NPC_ARENA_H
+#define NPC_ARENA_H
+
+#include "npc.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Арена для объектов NPC: память берется крупными блоками (slab), объекты
+// размещаются подряд сдвигом указателя. Отдельного освобождения нет -
+// clear() разрушает все объекты разом и оставляет блоки для следующей
+// популяции, деструктор арены отдает блоки системе.
+//
+// Миллион NPC - это несколько десятков malloc вместо миллиона.
+// Арена не потокобезопасна: заполняется одним потоком.
+class NPCArena {
+public:
+    static constexpr size_t DEFAULT_SLAB_BYTES = size_t{1} << 20;
+
+    explicit NPCArena(size_t slabBytes = DEFAULT_SLAB_BYTES) : slabBytes(slabBytes) {}
+    ~NPCArena() { clear(); }
+
+    NPCArena(const NPCArena&) = delete;
+    NPCArena& operator=(const NPCArena&) = delete;
+
+    // Создает T (наследник NPC) в арене; объект живет до clear()
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(std::is_base_of<NPC, T>::value, "NPCArena stores NPC objects only");
+        void* place = allocate(sizeof(T), alignof(T));
+        T* npc = new (place) T(std::forward<Args>(args)...);
+        objects.push_back(npc);
+        return npc;
+    }
+
+    // Заранее выделяет память под count объектов размера objectSize
+    void reserve(size_t count, size_t objectSize = sizeof(NPC)) {
+        objects.reserve(objects.size() + count);
+        size_t need = count * alignUp(objectSize, alignof(std::max_align_t));
+        size_t have = 0;
+        for (size_t s = current; s < slabs.size(); ++s) {
+            have += slabs[s].size - (s == current ? used : 0);
+        }
+        while (have < need) {
+            size_t bytes = std::max(slabBytes, need - have);
+            slabs.push_back(Slab{std::unique_ptr<unsigned char[]>(new unsigned char[bytes]), bytes});
+            have += bytes;
+        }
+    }
+
+    // Разрушает все объекты; блоки памяти остаются за ареной
+    void clear() {
+        for (auto it = objects.rbegin(); it != objects.rend(); ++it) {
+            (*it)->~NPC();
+        }
+        objects.clear();
+        current = 0;
+        used = 0;
+    }
+
+    // Разрушает объекты и отдает память
+    void release() {
+        clear();
+        slabs.clear();
+        slabs.shrink_to_fit();
+        objects.shrink_to_fit();
+    }
+
+    size_t size() const { return objects.size(); }
+    bool empty() const { return objects.empty(); }
+    NPC& operator[](size_t i) const { return *objects[i]; }
+
+    std::vector<NPC*>::const_iterator begin() const { return objects.begin(); }
+    std::vector<NPC*>::const_iterator end() const { return objects.end(); }
+
+    // Статистика: сколько блоков и байт держит арена
+    size_t slabCount() const { return slabs.size(); }
+    size_t bytesReserved() const {
+        size_t total = 0;
+        for (const auto& slab : slabs) total += slab.size;
+        return total;
+    }
+
+private:
+    struct Slab {
+        std::unique_ptr<unsigned char[]> memory;
+        size_t size;
+    };
+
+    size_t slabBytes;
+    std::vector<Slab> slabs;
+    size_t current = 0;  // блок, из которого сейчас раздаем память
+    size_t used = 0;     // занято байт в текущем блоке
+    std::vector<NPC*> objects;
+
+    static size_t alignUp(size_t value, size_t align) {
+        return (value + align - 1) & ~(align - 1);
+    }
+
+    void* allocate(size_t bytes, size_t align) {
+        while (current < slabs.size()) {
+            // new[] выравнивает начало блока по max_align_t
+            size_t offset = alignUp(used, align);
+            if (offset + bytes <= slabs[current].size) {
+                used = offset + bytes;
+                return slabs[current].memory.get() + offset;
+            }
+            current++;
+            used = 0;
+        }
+        size_t slabSize = std::max(slabBytes, bytes);
+        slabs.push_back(Slab{std::unique_ptr<unsigned char[]>(new unsigned char[slabSize]), slabSize});
+        current = slabs.size() - 1;
+        used = bytes;
+        return slabs[current].memory.get();
+    }
+};
+
+#endif
@@ -0,0 +1,35 @@
+#include "pending_pairs.h"
+
+bool PendingPairs::tryAcquire(NPCId a, NPCId b) {
+    uint64_t k = key(a, b);
+    Stripe& stripe = stripeFor(k);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    if (!stripe.pairs.insert(k).second) {
+        suppressedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void PendingPairs::release(NPCId a, NPCId b) {
+    uint64_t k = key(a, b);
+    Stripe& stripe = stripeFor(k);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.pairs.erase(k);
+}
+
+void PendingPairs::clear() {
+    for (Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.pairs.clear();
+    }
+}
+
+size_t PendingPairs::size() const {
+    size_t total = 0;
+    for (const Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        total += stripe.pairs.size();
+    }
+    return total;
+}
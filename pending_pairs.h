@@ -0,0 +1,49 @@
+#ifndef PENDING_PAIRS_H
+#define PENDING_PAIRS_H
+
+#include "world.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+
+// Множество боев "в полете": пара попадает сюда при постановке в очередь
+// и уходит, когда бой разрешен (или отброшен). Пока пара здесь, поиск
+// пар не ставит ее повторно. Пара неупорядоченная: (a, d) и (d, a) -
+// один и тот же бой, второй все равно не состоится после первого.
+//
+// Множество разбито на полосы со своим мьютексом: поток поиска пар
+// добавляет, потоки боев удаляют, и они почти не пересекаются.
+class PendingPairs {
+public:
+    // true - пары не было и теперь она отмечена; false - дубликат
+    bool tryAcquire(NPCId a, NPCId b);
+
+    // Снимает отметку (бой разрешен или не попал в очередь)
+    void release(NPCId a, NPCId b);
+
+    // Снимает все отметки (сжатие мира перенумеровало NPC)
+    void clear();
+
+    size_t size() const;
+    uint64_t suppressed() const { return suppressedCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t STRIPES = 64;
+
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::unordered_set<uint64_t> pairs;
+    };
+
+    std::array<Stripe, STRIPES> stripes;
+    std::atomic<uint64_t> suppressedCount{0};
+
+    static uint64_t key(NPCId a, NPCId b) {
+        return a < b ? (uint64_t{a} << 32 | b) : (uint64_t{b} << 32 | a);
+    }
+    Stripe& stripeFor(uint64_t k) { return stripes[splitmix64(k) % STRIPES]; }
+};
+
+#endif
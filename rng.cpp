@@ -0,0 +1,67 @@
+#include "rng.h"
+#include <atomic>
+#include <random>
+
+namespace {
+
+std::atomic<uint64_t> masterSeedValue{0x6C61623037ull};
+std::atomic<uint64_t> seedEpoch{1};
+
+// Потоки без закрепленного номера получают номера по порядку
+std::atomic<uint64_t> nextAnonymousStream{1u << 20};
+
+struct ThreadRng {
+    Xoshiro256 gen;
+    uint64_t epoch = 0;
+    uint64_t stream = 0;
+    bool bound = false;
+};
+
+thread_local ThreadRng threadRng;
+
+}
+
+void Xoshiro256::reseed(uint64_t seed) {
+    // Состояние заполняется через splitmix64, как рекомендуют авторы
+    for (auto& word : s) {
+        seed = splitmix64(seed);
+        word = seed;
+    }
+}
+
+void Rng::setMasterSeed(uint64_t seed) {
+    masterSeedValue = seed;
+    seedEpoch++;
+}
+
+uint64_t Rng::masterSeed() {
+    return masterSeedValue;
+}
+
+uint64_t Rng::randomSeed() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+}
+
+uint64_t Rng::streamSeed(uint64_t stream) {
+    return splitmix64(masterSeedValue.load() ^ splitmix64(stream));
+}
+
+void Rng::bindThreadStream(uint64_t stream) {
+    threadRng.stream = stream;
+    threadRng.bound = true;
+    threadRng.epoch = 0;  // пересоздать генератор при следующем вызове
+}
+
+Xoshiro256& Rng::local() {
+    ThreadRng& state = threadRng;
+    uint64_t epoch = seedEpoch.load(std::memory_order_relaxed);
+    if (state.epoch != epoch) {
+        if (!state.bound && state.epoch == 0) {
+            state.stream = nextAnonymousStream++;
+        }
+        state.gen.reseed(streamSeed(state.stream));
+        state.epoch = epoch;
+    }
+    return state.gen;
+}
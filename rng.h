@@ -0,0 +1,94 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <limits>
+
+// Быстрый генератор xoshiro256** (256 бит состояния вместо 5 КБ у mt19937).
+// Подходит как UniformRandomBitGenerator для <random>.
+class Xoshiro256 {
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256(uint64_t seed = 0) { reseed(seed); }
+
+    void reseed(uint64_t seed);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<uint64_t>::max(); }
+
+    result_type operator()() {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Равномерное целое из [lo, hi] умножением со сдвигом (метод Лемира
+    // без отбраковки: смещение порядка (hi - lo) / 2^32, для игры не важно)
+    int uniform(int lo, int hi) {
+        uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(hi) - lo) + 1;
+        uint64_t r = (*this)() >> 32;
+        return static_cast<int>(lo + static_cast<int64_t>((r * range) >> 32));
+    }
+};
+
+// Перемешивание splitmix64: из одного числа получает хорошо
+// распределенное другое (используется для вывода сидов потоков)
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Бросок кубиков боя от ключа: атакующий побеждает, если его кубик
+// больше. Результат зависит только от ключа, а не от потока или процесса.
+inline bool attackerWinsDice(uint64_t key) {
+    uint64_t r = splitmix64(key);
+    int attack = 1 + static_cast<int>(((r & 0xFFFFFFFFull) * 6) >> 32);
+    int defense = 1 + static_cast<int>(((r >> 32) * 6) >> 32);
+    return attack > defense;
+}
+
+// Сервис случайных чисел: один главный сид, из которого выводятся
+// независимые потоки. У каждого потока выполнения свой генератор
+// (thread_local), поэтому вызовы не берут блокировок.
+class Rng {
+public:
+    // Номера фиксированных потоков случайности
+    static constexpr uint64_t SPAWN_STREAM = 1;
+    static constexpr uint64_t MOVEMENT_STREAM = 2;
+    static constexpr uint64_t BATTLE_ROUND_STREAM = 3;
+    static constexpr uint64_t BATTLE_STREAM_BASE = 1000;
+
+    // Меняет главный сид; генераторы потоков пересоздаются при следующем вызове
+    static void setMasterSeed(uint64_t seed);
+    static uint64_t masterSeed();
+
+    // Случайный сид из std::random_device (один раз за запуск)
+    static uint64_t randomSeed();
+
+    // Сид и генератор для потока с номером stream
+    static uint64_t streamSeed(uint64_t stream);
+    static Xoshiro256 stream(uint64_t stream) { return Xoshiro256(streamSeed(stream)); }
+
+    // Закрепляет за текущим потоком выполнения номер потока случайности,
+    // чтобы его последовательность воспроизводилась от запуска к запуску
+    static void bindThreadStream(uint64_t stream);
+
+    // Генератор текущего потока выполнения
+    static Xoshiro256& local();
+};
+
+#endif
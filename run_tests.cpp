@@ -1,11 +1,37 @@
+// Тесты на assert должны работать и в Release-сборке
+#undef NDEBUG
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <random>
 #include <mutex>
 #include <atomic>
 #include <shared_mutex>
+#include <thread>
+#include <chrono>
+#include <vector>
 #include "npc.h"
 #include "factory.h"
+#include "broadphase.h"
+#include "kill_kernel.h"
+#include "battle_pool.h"
+#include "bounded_ring.h"
+#include "rng.h"
+#include "game.h"
+#include "thread_pool.h"
+#include "snapshot.h"
+#include "battle_log.h"
+#include "world_file.h"
+#include "shards.h"
+#include "cluster.h"
+#include "metrics.h"
+#include "map_renderer.h"
+#include "journal.h"
+#include "lz_block.h"
+#include <fstream>
+#include <iterator>
+#include <cstdio>
 
 void runAllTests() {
     std::cout << "=== Running Lab07 Tests ===\n\n";
@@ -139,7 +165,1259 @@ void runAllTests() {
     }
     std::cout << "PASSED ✓\n";
     
-    std::cout << "\n=== All 8 tests PASSED! ===\n";
+    // Тест 9: Сетка находит те же пары, что и полный перебор
+    std::cout << "Test 9: Uniform grid broadphase... ";
+    {
+        World world;
+        for (const auto& npc : NPCFactory::createRandomNPCs(500, 300, 200)) {
+            world.add(*npc);
+        }
+        world.kill(world.handle(3));
+        world.kill(world.handle(10));
+        
+        BruteForceBroadphase brute;
+        UniformGridBroadphase grid;
+        std::vector<BattlePair> brutePairs, gridPairs;
+        brute.findPairs(world, 300, 200, brutePairs);
+        grid.findPairs(world, 300, 200, gridPairs);
+        
+        assert(!brutePairs.empty());
+        assert(brutePairs.size() == gridPairs.size());
+        for (size_t k = 0; k < brutePairs.size(); ++k) {
+            assert(brutePairs[k].attacker == gridPairs[k].attacker);
+            assert(brutePairs[k].defender == gridPairs[k].defender);
+        }
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 10: Хранилище World и NPC как представление
+    std::cout << "Test 10: SoA world store... ";
+    {
+        World world;
+        NPCHandle orc = world.add(Orc("WorldOrc", 10, 20));
+        NPCHandle elf = world.add(Elf("WorldElf", 0, 0));
+        assert(world.size() == 2);
+        assert(orc.index == 0 && elf.index == 1);
+        assert(world.getType(elf) == NPCType::ELF);
+        assert(world.getKillDistance(elf) == 50);
+        
+        world.setPosition(orc, 30, 40);
+        world.kill(elf);
+        
+        NPC view = world.view(orc);
+        assert(view.getName() == "WorldOrc");
+        assert(view.getX() == 30 && view.getY() == 40);
+        assert(view.getMoveDistance() == 20);
+        assert(!world.view(elf).isAlive());
+        assert(world.view(elf).toString().find("DEAD") != std::string::npos);
+        
+        // Мертвый NPC в World не двигается
+        world.move(elf, 100, 100);
+        assert(world.getX(elf) == 0 && world.getY(elf) == 0);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 11: Векторные ядра совпадают со скалярным
+    std::cout << "Test 11: SIMD kill-range kernel... ";
+    {
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<> posDist(0, 120);
+        int xs[KILL_BLOCK], ys[KILL_BLOCK];
+        
+        // Точно на границе: 3-4-5
+        assert(killMaskScalar(0, 0, 5, xs, ys, 0) == 0);
+        xs[0] = 3; ys[0] = 4;
+        xs[1] = 4; ys[1] = 4;
+        assert(killMaskScalar(0, 0, 5, xs, ys, 2) == 0x1u);
+        
+        for (SimdLevel level : {SimdLevel::SSE41, SimdLevel::AVX2}) {
+            KillMaskFn fn = killKernelFor(level);
+            if (!fn || static_cast<int>(level) > static_cast<int>(detectSimdLevel())) {
+                continue;
+            }
+            for (int round = 0; round < 1000; ++round) {
+                size_t count = static_cast<size_t>(round % (KILL_BLOCK + 1));
+                for (size_t k = 0; k < count; ++k) {
+                    xs[k] = posDist(gen);
+                    ys[k] = posDist(gen);
+                }
+                int ax = posDist(gen), ay = posDist(gen), kill = round % 60;
+                assert(fn(ax, ay, kill, xs, ys, count) ==
+                       killMaskScalar(ax, ay, kill, xs, ys, count));
+            }
+            
+            // Наибольшая дистанция векторного ядра: 2 * (d + 1)^2 не
+            // переполняет int32, угол квадрата вне круга
+            const int d = MAX_SIMD_KILL_DISTANCE;
+            const int far[][2] = {{d, 0}, {0, -d}, {d, 1}, {d + 1, d + 1}, {-d - 1, d + 1},
+                                  {100000, 100000}, {d / 2, d / 2}, {-1000000, 7}};
+            const size_t farCount = sizeof(far) / sizeof(far[0]);
+            for (size_t k = 0; k < farCount; ++k) {
+                xs[k] = far[k][0];
+                ys[k] = far[k][1];
+            }
+            assert(killMaskScalar(0, 0, d, xs, ys, farCount) == 0x43u);
+            assert(fn(0, 0, d, xs, ys, farCount) == 0x43u);
+        }
+        assert(killMask(0, 0, MAX_SIMD_KILL_DISTANCE + 1, xs, ys, 8) ==
+               killMaskScalar(0, 0, MAX_SIMD_KILL_DISTANCE + 1, xs, ys, 8));
+        
+        // canKill без sqrt дает тот же ответ
+        Elf elf("Elf", 0, 0);
+        Squirrel edge("Edge", 30, 40);
+        assert(elf.canKill(edge));  // ровно 50
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 12: Пул боев выполняет каждую задачу ровно один раз
+    std::cout << "Test 12: Work-stealing battle pool... ";
+    {
+        const size_t taskCount = 20000;
+        std::vector<std::atomic<int>> runs(taskCount);
+        for (auto& r : runs) r = 0;
+        
+        BattlePool pool(4, taskCount, [&runs](const BattleTask& task) {
+            runs[task.attacker.index]++;
+        });
+        for (size_t i = 0; i < taskCount; ++i) {
+            assert(pool.submit({NPCHandle{static_cast<uint32_t>(i)}, NPCHandle{0}}));
+        }
+        pool.waitIdle();
+        
+        assert(pool.executed() == taskCount);
+        for (const auto& r : runs) assert(r == 1);
+        
+        // Переполнение очереди отбрасывает задачи, а не растит ее
+        BattlePool tiny(1, 1, [](const BattleTask&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+        size_t accepted = 0;
+        for (int i = 0; i < 10; ++i) {
+            if (tiny.submit({NPCHandle{0}, NPCHandle{1}})) accepted++;
+        }
+        assert(accepted < 10);
+        assert(tiny.dropped() == 10 - accepted);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 13: Lock-free кольцо для передачи боев
+    std::cout << "Test 13: Bounded lock-free ring... ";
+    {
+        BoundedRing<int> ring(5);
+        assert(ring.capacity() == 8);
+        
+        int items[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+        assert(ring.pushBatch(items, 10) == 8);
+        assert(ring.depth() == 8);
+        assert(ring.dropped() == 2);
+        assert(ring.backpressured() == 1);
+        
+        int out[8];
+        assert(ring.popBatch(out, 8) == 8);
+        for (int i = 0; i < 8; ++i) assert(out[i] == i);
+        assert(ring.depth() == 0);
+        
+        // Несколько производителей и потребителей
+        BoundedRing<int> shared(1024);
+        const int perProducer = 50000;
+        std::atomic<long long> sum{0};
+        std::atomic<int> consumed{0};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < 2; ++p) {
+            threads.emplace_back([&shared]() {
+                for (int v = 1; v <= perProducer; ++v) {
+                    while (!shared.tryPush(v)) std::this_thread::yield();
+                }
+            });
+        }
+        for (int c = 0; c < 2; ++c) {
+            threads.emplace_back([&]() {
+                int v;
+                while (consumed < 2 * perProducer) {
+                    if (shared.tryPop(v)) {
+                        sum += v;
+                        consumed++;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        assert(sum == 2LL * perProducer * (perProducer + 1) / 2);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 14: Воспроизводимость по главному сиду
+    std::cout << "Test 14: Seeded RNG streams... ";
+    {
+        Rng::setMasterSeed(12345);
+        auto first = NPCFactory::createRandomNPCs(20, 100, 100);
+        Orc walkerA("A", 50, 50);
+        for (int i = 0; i < 10; ++i) walkerA.move(100, 100);
+        
+        Rng::setMasterSeed(12345);
+        auto second = NPCFactory::createRandomNPCs(20, 100, 100);
+        Orc walkerB("B", 50, 50);
+        for (int i = 0; i < 10; ++i) walkerB.move(100, 100);
+        
+        for (size_t i = 0; i < first.size(); ++i) {
+            assert(first[i]->getType() == second[i]->getType());
+            assert(first[i]->getX() == second[i]->getX());
+            assert(first[i]->getY() == second[i]->getY());
+        }
+        assert(walkerA.getX() == walkerB.getX() && walkerA.getY() == walkerB.getY());
+        
+        // Разные потоки - разные последовательности
+        Xoshiro256 s1 = Rng::stream(1), s2 = Rng::stream(2);
+        assert(s1() != s2());
+        
+        // uniform не выходит за границы
+        Xoshiro256 gen(99);
+        for (int i = 0; i < 10000; ++i) {
+            int v = gen.uniform(-3, 3);
+            assert(v >= -3 && v <= 3);
+        }
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 15: Прогон без отображения
+    std::cout << "Test 15: Headless fixed-timestep run... ";
+    {
+        GameConfig config;
+        config.npcCount = 300;
+        config.mapX = 200;
+        config.mapY = 200;
+        config.seed = 77;
+        config.battleWorkers = 1;
+        config.battleLog = LogDestination::DISCARD;
+        
+        std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+        SimulationReport first = Game(config).runHeadless(50);
+        SimulationReport second = Game(config).runHeadless(50);
+        std::cout.rdbuf(oldBuf);
+        
+        assert(first.ticks == 50);
+        assert(first.alive + first.dead == 300);
+        assert(first.battlesFought == first.dead);
+        assert(first.battlesFought > 0);
+        
+        // Один поток боев и один сид - один и тот же результат
+        assert(first.alive == second.alive);
+        assert(first.aliveByType == second.aliveByType);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 16: Параллельное движение в задний буфер
+    std::cout << "Test 16: Parallel double-buffered movement... ";
+    {
+        ThreadPool pool(4);
+        std::vector<std::atomic<int>> hits(10000);
+        for (auto& h : hits) h = 0;
+        pool.parallelFor(hits.size(), 64, [&hits](size_t begin, size_t end) {
+            assert(begin % 64 == 0);
+            for (size_t i = begin; i < end; ++i) hits[i]++;
+        });
+        for (const auto& h : hits) assert(h == 1);
+        
+        // До publishPositions текущие позиции не меняются
+        World world;
+        world.add(Dragon("D", 50, 50));
+        Xoshiro256 gen(3);
+        for (int i = 0; i < 20; ++i) {
+            world.computeMoves(0, 1, 100, 100, gen);
+            assert(world.getX(world.handle(0)) == 50 && world.getY(world.handle(0)) == 50);
+        }
+        world.publishPositions();
+        int x = world.getX(world.handle(0)), y = world.getY(world.handle(0));
+        assert(x >= 0 && x < 100 && y >= 0 && y < 100);
+        
+        // Результат не зависит от числа потоков движения
+        GameConfig config;
+        config.npcCount = 20000;
+        config.mapX = 3000;
+        config.mapY = 3000;
+        config.seed = 99;
+        config.battleWorkers = 1;
+        config.battleLog = LogDestination::DISCARD;
+        
+        std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+        config.movementThreads = 1;
+        SimulationReport single = Game(config).runHeadless(10);
+        config.movementThreads = 4;
+        SimulationReport multi = Game(config).runHeadless(10);
+        std::cout.rdbuf(oldBuf);
+        
+        assert(single.alive == multi.alive);
+        assert(single.aliveByType == multi.aliveByType);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 17: Снимки мира для наблюдателей
+    std::cout << "Test 17: RCU world snapshots... ";
+    {
+        World world;
+        NPCHandle orc = world.add(Orc("SnapOrc", 1, 2));
+        SnapshotPublisher publisher;
+        assert(publisher.acquire() == nullptr);
+        
+        publisher.publish(world, 1, 100, 100);
+        std::shared_ptr<const WorldSnapshot> first = publisher.acquire();
+        
+        // Изменения мира не видны в уже взятом снимке
+        world.setPosition(orc, 9, 9);
+        world.kill(orc);
+        world.add(Elf("Late", 0, 0));
+        publisher.publish(world, 2, 100, 100);
+        
+        assert(first->tick == 1 && first->size() == 1);
+        assert(first->x[0] == 1 && first->isAlive(0));
+        assert(first->getName(0) == "SnapOrc");
+        
+        std::shared_ptr<const WorldSnapshot> second = publisher.acquire();
+        assert(second->tick == 2 && second->size() == 2);
+        assert(!second->isAlive(0) && second->x[0] == 9);
+        assert(second->view(1).getName() == "Late");
+        
+        // Снимок Game после прогона совпадает с отчетом
+        GameConfig config;
+        config.npcCount = 500;
+        config.seed = 5;
+        config.battleLog = LogDestination::DISCARD;
+        std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+        Game game(config);
+        SimulationReport report = game.runHeadless(5);
+        std::cout.rdbuf(oldBuf);
+        
+        auto snap = game.snapshot();
+        size_t alive = 0;
+        for (size_t i = 0; i < snap->size(); ++i) alive += snap->isAlive(i);
+        assert(snap->size() + snap->removed == 500 && alive == report.alive);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 18: Асинхронный журнал боев
+    std::cout << "Test 18: Async battle log sink... ";
+    {
+        World world;
+        world.add(Orc("LogOrc", 0, 0));
+        world.add(Elf("LogElf", 1, 1));
+        const std::string path = "lab07_test_battles.log";
+        
+        {
+            BattleLog log(LogDestination::FILE, path, world.sharedStatics());
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&log, t]() {
+                    for (uint32_t i = 0; i < 250; ++i) {
+                        log.record({i, 0, 1, static_cast<uint32_t>(t % 2)});
+                    }
+                });
+            }
+            for (auto& th : threads) th.join();
+            log.flush();
+            assert(log.written() == 1000);
+            assert(log.dropped() == 0);
+        }
+        
+        std::ifstream in(path);
+        std::string line;
+        int lines = 0, orcWins = 0;
+        while (std::getline(in, line)) {
+            lines++;
+            if (line == "BATTLE: LogOrc vs LogElf -> LogOrc wins!") orcWins++;
+        }
+        in.close();
+        std::remove(path.c_str());
+        assert(lines == 1000 && orcWins == 500);
+        
+        // Переполнение буфера потока считается, а не блокирует
+        BattleLog tiny(LogDestination::FILE, path, world.sharedStatics(), nullptr, 10);
+        for (uint32_t i = 0; i < 1000; ++i) tiny.record({0, 0, 1, 1});
+        tiny.stop();
+        assert(tiny.written() + tiny.dropped() == 1000);
+        assert(tiny.dropped() > 0);
+        std::remove(path.c_str());
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 19: Двоичный снимок мира
+    std::cout << "Test 19: Binary world snapshot save/load... ";
+    {
+        const std::string path = "lab07_test_world.l7w";
+        GameConfig config;
+        config.npcCount = 800;
+        config.mapX = 300;
+        config.mapY = 200;
+        config.seed = 19;
+        config.battleWorkers = 1;
+        config.battleLog = LogDestination::DISCARD;
+        
+        std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+        Game game(config);
+        game.runHeadless(10);
+        uint64_t savedTick = game.saveSnapshot(path);
+        auto saved = game.snapshot();
+        
+        GameConfig loadConfig = config;
+        loadConfig.npcCount = 1;
+        loadConfig.mapX = loadConfig.mapY = 10;
+        loadConfig.loadPath = path;
+        Game restored(loadConfig);
+        std::cout.rdbuf(oldBuf);
+        
+        auto snap = restored.snapshot();
+        assert(savedTick == 10 && snap->tick == savedTick);
+        assert(snap->mapX == 300 && snap->mapY == 200);
+        assert(snap->size() == saved->size());
+        for (size_t i = 0; i < snap->size(); ++i) {
+            assert(snap->x[i] == saved->x[i] && snap->y[i] == saved->y[i]);
+            assert(snap->alive[i] == saved->alive[i] && snap->health[i] == saved->health[i]);
+            assert(snap->getName(i) == saved->getName(i));
+            assert(snap->getType(i) == saved->getType(i));
+            assert(snap->statics->killDistance[i] == saved->statics->killDistance[i]);
+        }
+        
+        // Отображенный файл читается напрямую
+        {
+            WorldFile file(path);
+            assert(file.header().version == WORLD_FILE_VERSION);
+            assert(file.npcCount() == saved->size());
+            assert(file.xs()[7] == saved->x[7] && file.alive()[7] == saved->alive[7]);
+            assert(file.name(0) == saved->getName(0));
+            assert(file.type(0) == saved->getType(0));
+        }
+        
+        // Произвольные имена идут через таблицу имен файла, остальные - номером
+        {
+            World named;
+            named.add(Orc("Grom", 1, 2));
+            named.add(Elf("Elf_7", 3, 4));
+            named.add(Orc("Grom", 5, 6));
+            SnapshotPublisher publisher;
+            publisher.publish(named, 3, 10, 10);
+            WorldFile::save(path, *publisher.acquire());
+            WorldFile file(path);
+            assert(file.header().nameCount == 1 && file.name(2) == "Grom");
+            LoadedWorld back = file.load();
+            assert(back.world.getName(back.world.handle(0)) == "Grom");
+            assert(back.world.getName(back.world.handle(1)) == "Elf_7");
+            assert(back.world.getX(back.world.handle(2)) == 5 && back.tick == 3);
+        }
+        
+        // Поврежденный файл отвергается
+        {
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(8);
+            uint32_t badVersion = 99;
+            f.write(reinterpret_cast<const char*>(&badVersion), sizeof(badVersion));
+        }
+        bool rejected = false;
+        try {
+            WorldFile file(path);
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        assert(rejected);
+        std::remove(path.c_str());
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 20: Арена NPC
+    std::cout << "Test 20: NPC arena allocation... ";
+    {
+        NPCArena arena(4096);
+        Orc* orc = arena.create<Orc>("ArenaOrc", 1, 2);
+        assert(orc->getName() == "ArenaOrc" && arena.size() == 1);
+        for (int i = 0; i < 1000; ++i) arena.create<Elf>("Elf", i, i);
+        assert(arena.size() == 1001 && arena.slabCount() > 1);
+        assert(arena[1000].getX() == 999 && arena[0].getType() == NPCType::ORC);
+        
+        // clear сохраняет блоки для следующей популяции
+        size_t slabs = arena.slabCount();
+        arena.clear();
+        assert(arena.empty() && arena.slabCount() == slabs);
+        for (int i = 0; i < 1000; ++i) arena.create<Bull>("Bull", 0, 0);
+        assert(arena.slabCount() == slabs);
+        
+        // Популяция в арене совпадает с версией на unique_ptr
+        Rng::setMasterSeed(13);
+        auto owned = NPCFactory::createRandomNPCs(500, 100, 100);
+        Rng::setMasterSeed(13);
+        NPCArena population;
+        NPCFactory::createRandomNPCs(population, 500, 100, 100);
+        assert(population.size() == owned.size());
+        for (size_t i = 0; i < owned.size(); ++i) {
+            assert(population[i].toString() == owned[i]->toString());
+        }
+        
+        population.release();
+        assert(population.empty() && population.slabCount() == 0);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 21: Интернированные имена
+    std::cout << "Test 21: Interned NPC names... ";
+    {
+        NameTable table;
+        NameId generated = encodeName(table, NPCType::ORC, "Orc_17");
+        assert(!(generated & INTERNED_NAME) && generated == 17 && table.size() == 0);
+        assert(decodeName(generated, NPCType::ORC, table) == "Orc_17");
+        
+        // Имя чужого типа, с ведущим нулем или произвольное - в таблицу
+        NameId foreign = encodeName(table, NPCType::ELF, "Orc_17");
+        NameId padded = encodeName(table, NPCType::ORC, "Orc_017");
+        NameId custom = encodeName(table, NPCType::ORC, "Grommash");
+        assert((foreign & INTERNED_NAME) && (padded & INTERNED_NAME) && (custom & INTERNED_NAME));
+        assert(encodeName(table, NPCType::DRUID, "Grommash") == custom && table.size() == 3);
+        assert(decodeName(padded, NPCType::ORC, table) == "Orc_017");
+        assert(decodeName(custom, NPCType::DRUID, table) == "Grommash");
+        
+        std::string line = "BATTLE: ";
+        appendName(line, 4000000000u & ~INTERNED_NAME, NPCType::BULL, table);
+        assert(line == "BATTLE: Bull_1852516352");
+        
+        // В мире имена сгенерированной популяции не хранятся строками
+        Rng::setMasterSeed(21);
+        NPCArena arena;
+        NPCFactory::createRandomNPCs(arena, 1000, 100, 100);
+        World world;
+        for (const NPC* npc : arena) world.add(*npc);
+        world.add(Knight("Lancelot", 0, 0));
+        assert(world.sharedStatics()->nameTable.size() == 1);
+        for (size_t i = 0; i < arena.size(); ++i) {
+            assert(world.getName(world.handle(i)) == arena[i].getName());
+        }
+        assert(world.getName(world.handle(1000)) == "Lancelot");
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 22: Таблица свойств типов и совершенный хеш
+    std::cout << "Test 22: constexpr NPC traits and type hash... ";
+    {
+        static_assert(traitsOf(NPCType::ELF).killDistance == 50, "Elf kill range");
+        static_assert(Dragon::traits.health == 200, "Dragon health");
+        static_assert(NPC::stringToType("Pegasus") == NPCType::PEGASUS, "Pegasus hash");
+        
+        for (size_t t = 0; t < NPC_TYPE_COUNT; ++t) {
+            NPCType type = static_cast<NPCType>(t);
+            assert(NPC::stringToType(NPC::typeToString(type)) == type);
+            
+            auto npc = NPCFactory::createNPC(type, "T", 0, 0);
+            assert(npc->getHealth() == traitsOf(type).health);
+            assert(npc->getMoveDistance() == traitsOf(type).moveDistance);
+            assert(npc->getKillDistance() == traitsOf(type).killDistance);
+        }
+        assert(NPC::stringToType("orc") == NPCType::UNKNOWN);
+        assert(NPC::stringToType("") == NPCType::UNKNOWN);
+        assert(NPC::stringToType("Bulls") == NPCType::UNKNOWN);
+        assert(NPC::typeToString(NPCType::UNKNOWN) == "Unknown");
+        
+        // Шаг типизированного NPC ограничен его константой
+        Werewolf wolf("Wolf", 500, 500);
+        for (int i = 0; i < 100; ++i) {
+            int oldX = wolf.getX(), oldY = wolf.getY();
+            wolf.move(1000, 1000);
+            assert(std::abs(wolf.getX() - oldX) <= 40 && std::abs(wolf.getY() - oldY) <= 40);
+        }
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 23: Подавление повторных боев
+    std::cout << "Test 23: Pending battle pair de-duplication... ";
+    {
+        PendingPairs pending;
+        assert(pending.tryAcquire(1, 2));
+        assert(!pending.tryAcquire(1, 2));
+        assert(!pending.tryAcquire(2, 1));  // та же пара в другую сторону
+        assert(pending.tryAcquire(1, 3));
+        assert(pending.size() == 2 && pending.suppressed() == 2);
+        pending.release(2, 1);
+        assert(pending.tryAcquire(1, 2) && pending.size() == 2);
+        
+        // Параллельная постановка: каждую пару получает ровно один поток
+        PendingPairs shared;
+        std::atomic<int> acquired{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&]() {
+                for (NPCId i = 0; i < 1000; ++i) acquired += shared.tryAcquire(i, i + 1);
+            });
+        }
+        for (auto& th : threads) th.join();
+        assert(acquired == 1000 && shared.suppressed() == 3000);
+        
+        // В headless тик ждет свои бои, поэтому повторов не бывает:
+        // каждая пара снимается с учета до следующего поиска
+        GameConfig config;
+        config.npcCount = 400;
+        config.mapX = config.mapY = 60;
+        config.seed = 23;
+        config.battleLog = LogDestination::DISCARD;
+        std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+        Game game(config);
+        SimulationReport report = game.runHeadless(20);
+        std::cout.rdbuf(oldBuf);
+        assert(report.battlesSubmitted > 0 && report.battlesSuppressed == 0);
+        assert(report.battlesFought <= report.battlesSubmitted);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 24: Атомарное состояние NPC и tryKill
+    std::cout << "Test 24: Packed atomic NPC life and tryKill... ";
+    {
+        static_assert(NPCLife::alive(NPCLife::pack(true, 150)), "alive bit");
+        static_assert(NPCLife::health(NPCLife::pack(true, 150)) == 150, "health bits");
+        static_assert(NPCLife::pack(false, -5) == 0, "dead and clamped");
+        
+        World world;
+        for (int i = 0; i < 64; ++i) world.add(Orc("Target", i, i));
+        
+        // Много потоков бьют одних и тех же NPC: каждый убит ровно один раз
+        std::atomic<int> kills{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&world, &kills]() {
+                for (int round = 0; round < 100; ++round) {
+                    for (size_t i = 0; i < world.size(); ++i) {
+                        kills += world.tryKill(world.handle(i));
+                    }
+                }
+            });
+        }
+        for (auto& th : threads) th.join();
+        assert(kills == 64);
+        for (size_t i = 0; i < world.size(); ++i) {
+            assert(!world.isAlive(world.handle(i)) && world.getHealth(world.handle(i)) == 0);
+        }
+        
+        // Бои вперемешку: мертвый NPC никогда не побеждает. Метка смерти
+        // берется внутри tryFight, пока оба участника захвачены.
+        World arena;
+        for (int i = 0; i < 256; ++i) arena.add(Orc("Fighter", i, i));
+        std::atomic<uint64_t> stamp{0};
+        std::vector<std::atomic<uint64_t>> diedAt(arena.size());
+        for (auto& d : diedAt) d = UINT64_MAX;
+        struct Win { uint32_t winner; uint64_t at; };
+        std::vector<std::vector<Win>> wins(8);
+        std::vector<std::thread> fighters;
+        for (int t = 0; t < 8; ++t) {
+            fighters.emplace_back([&, t]() {
+                std::mt19937 rng(t);
+                for (int k = 0; k < 20000; ++k) {
+                    const uint32_t a = rng() % 256, b = rng() % 256;
+                    const bool attackerWins = rng() & 1;
+                    arena.tryFight(arena.handle(a), arena.handle(b), attackerWins,
+                                   [&](NPCHandle loser) {
+                        const uint64_t at = stamp++;
+                        diedAt[loser.index] = at;
+                        wins[t].push_back({attackerWins ? a : b, at});
+                    });
+                }
+            });
+        }
+        for (auto& th : fighters) th.join();
+        size_t credited = 0, dead = 0;
+        for (const auto& list : wins) {
+            for (const Win& w : list) {
+                assert(diedAt[w.winner] > w.at);
+                credited++;
+            }
+        }
+        for (size_t i = 0; i < arena.size(); ++i) {
+            assert(!NPCLife::engaged(arena.lifeWord(i)));
+            dead += !arena.isAlive(i);
+        }
+        assert(credited == dead && dead > 0);
+        
+        // Копия мира переносит слова жизни
+        World copy = world;
+        copy.add(Elf("Fresh", 0, 0));
+        assert(copy.size() == 65 && copy.isAlive(copy.handle(64)) && !copy.isAlive(copy.handle(0)));
+        assert(copy.getHealth(copy.handle(64)) == 70);
+        
+        // Бои без блокировок: число побед равно числу погибших
+        GameConfig config;
+        config.npcCount = 3000;
+        config.mapX = config.mapY = 150;
+        config.seed = 24;
+        config.battleScheduler = BattleScheduler::POOL;
+        config.battleWorkers = 8;
+        config.battleLog = LogDestination::DISCARD;
+        std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+        Game game(config);
+        SimulationReport report = game.runHeadless(20);
+        std::cout.rdbuf(oldBuf);
+        assert(report.battlesFought > 0 && report.battlesFought == report.dead);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 25: Раунды боев без конфликтов
+    std::cout << "Test 25: Conflict-free battle rounds... ";
+    {
+        // Звезда с центром 0 и цепочка 5-6-7
+        std::vector<BattlePair> pairs = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {5, 6}, {6, 7}};
+        BattleRoundPlanner planner;
+        planner.plan(pairs, 8);
+        assert(planner.battleCount() == pairs.size() && planner.roundCount() == 3);
+        
+        std::vector<int> lastIndex(8, -1);
+        for (size_t r = 0; r < planner.roundCount(); ++r) {
+            std::vector<int> seen(8, 0);
+            for (auto* b = planner.roundBegin(r); b != planner.roundEnd(r); ++b) {
+                // NPC встречается в раунде один раз
+                assert(++seen[b->pair.attacker] == 1 && ++seen[b->pair.defender] == 1);
+                // Бои NPC идут в порядке списка пар
+                assert(static_cast<int>(b->index) > lastIndex[b->pair.attacker]);
+                assert(static_cast<int>(b->index) > lastIndex[b->pair.defender]);
+                lastIndex[b->pair.attacker] = lastIndex[b->pair.defender] = b->index;
+            }
+        }
+        
+        // Повторное планирование не видит прошлых раундов
+        planner.plan({{2, 3}}, 8);
+        assert(planner.roundCount() == 1 && planner.roundSize(0) == 1);
+        
+        // Итог зависит только от сида, не от числа потоков
+        auto run = [](int threads) {
+            GameConfig config;
+            config.npcCount = 4000;
+            config.mapX = config.mapY = 200;
+            config.seed = 25;
+            config.movementThreads = threads;
+            config.battleLog = LogDestination::DISCARD;
+            std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+            Game game(config);
+            SimulationReport report = game.runHeadless(15);
+            std::cout.rdbuf(oldBuf);
+            assert(report.battleRounds > 0 && report.battlesFought == report.dead);
+            return std::make_pair(report.battlesFought, game.snapshot()->alive);
+        };
+        auto single = run(1);
+        auto parallel = run(4);
+        assert(single.first > 0 && single == parallel);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 26: Списки соседей Верле
+    std::cout << "Test 26: Verlet neighbor lists... ";
+    {
+        // Медленные NPC с большой дальностью - случай, где списки выгодны
+        World world;
+        Rng::setMasterSeed(26);
+        Xoshiro256 place = Rng::stream(Rng::SPAWN_STREAM);
+        for (int i = 0; i < 1500; ++i) {
+            int x = place.uniform(0, 599), y = place.uniform(0, 599);
+            if (i % 3 == 0) world.add(Elf("Elf", x, y));
+            else world.add(Toad("Toad", x, y));
+        }
+        
+        BruteForceBroadphase brute;
+        VerletBroadphase verlet(4);
+        std::vector<BattlePair> brutePairs, verletPairs;
+        Xoshiro256 gen = Rng::stream(Rng::MOVEMENT_STREAM);
+        const int ticks = 30;
+        for (int tick = 0; tick < ticks; ++tick) {
+            world.computeMoves(0, world.size(), 600, 600, gen);
+            world.publishPositions();
+            if (tick % 7 == 3) world.kill(world.handle(tick * 11));
+            
+            brute.findPairs(world, 600, 600, brutePairs);
+            verlet.findPairs(world, 600, 600, verletPairs);
+            assert(brutePairs.size() == verletPairs.size());
+            for (size_t k = 0; k < brutePairs.size(); ++k) {
+                assert(brutePairs[k].attacker == verletPairs[k].attacker);
+                assert(brutePairs[k].defender == verletPairs[k].defender);
+            }
+        }
+        
+        BroadphaseStats stats = verlet.stats();
+        assert(stats.calls == ticks && stats.fallbacks == 0);
+        assert(stats.rebuilds >= 1 && stats.rebuilds <= ticks / 3);
+        assert(stats.candidates >= brutePairs.size() && stats.maxCandidates >= stats.candidates);
+        
+        // Новый NPC в мире - всегда перестройка
+        world.add(Elf("Late", 0, 0));
+        verlet.findPairs(world, 600, 600, verletPairs);
+        assert(verlet.stats().rebuilds == stats.rebuilds + 1);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 27: Шардированный broadphase с halo и миграцией
+    std::cout << "Test 27: Sharded broadphase with halo and migration... ";
+    {
+        // Вытянутая карта: полосы по x, NPC постоянно переходят границы
+        World world;
+        Rng::setMasterSeed(27);
+        Xoshiro256 place = Rng::stream(Rng::SPAWN_STREAM);
+        const int mapW = 1200, mapH = 300;
+        for (int i = 0; i < 2000; ++i) {
+            int x = place.uniform(0, mapW - 1), y = place.uniform(0, mapH - 1);
+            world.add(*NPCFactory::createNPC(static_cast<NPCType>(i % NPC_TYPE_COUNT),
+                                             "N" + std::to_string(i), x, y));
+        }
+        
+        BruteForceBroadphase brute;
+        ShardedBroadphase one(1), sharded(5);
+        std::vector<BattlePair> brutePairs, onePairs, shardPairs;
+        Xoshiro256 gen = Rng::stream(Rng::MOVEMENT_STREAM);
+        const int ticks = 20;
+        for (int tick = 0; tick < ticks; ++tick) {
+            world.computeMoves(0, world.size(), mapW, mapH, gen);
+            world.publishPositions();
+            if (tick % 4 == 1) world.kill(world.handle(tick * 37));
+            
+            brute.findPairs(world, mapW, mapH, brutePairs);
+            one.findPairs(world, mapW, mapH, onePairs);
+            sharded.findPairs(world, mapW, mapH, shardPairs);
+            assert(brutePairs.size() == shardPairs.size() && brutePairs.size() == onePairs.size());
+            for (size_t k = 0; k < brutePairs.size(); ++k) {
+                assert(brutePairs[k].attacker == shardPairs[k].attacker);
+                assert(brutePairs[k].defender == shardPairs[k].defender);
+                assert(brutePairs[k].attacker == onePairs[k].attacker);
+                assert(brutePairs[k].defender == onePairs[k].defender);
+            }
+            
+            // Каждый живой NPC принадлежит ровно одному шарду - своей полосе
+            std::vector<int> owners(world.size(), 0);
+            for (size_t s = 0; s < sharded.shardCount(); ++s) {
+                for (NPCId id : sharded.owned(s)) {
+                    owners[id]++;
+                    assert(sharded.shardFor(world.xs()[id]) == s);
+                }
+            }
+            for (size_t i = 0; i < world.size(); ++i) {
+                assert(owners[i] == (world.isAlive(i) ? 1 : 0));
+            }
+        }
+        
+        BroadphaseStats stats = sharded.stats();
+        assert(stats.calls == ticks && stats.rebuilds == 1 && stats.shards == 5);
+        assert(stats.migrations > 0 && stats.haloEntries > 0);
+        assert(one.stats().migrations == 0 && one.stats().haloEntries == 0);
+        
+        // Полоса не уже max killDistance: на узкой карте шардов меньше
+        ShardedBroadphase narrow(8);
+        narrow.findPairs(world, 100, 100, shardPairs);
+        assert(narrow.shardCount() >= 1 && narrow.shardCount() <= 3);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 28: Кластер шардов через Unix-сокеты
+    std::cout << "Test 28: Shard cluster over Unix sockets... ";
+    {
+        // Формат провода: little-endian, запись NPC - 24 байта
+        WireWriter writer;
+        WireNPC npc;
+        npc.id = 7;
+        npc.x = -3;
+        npc.y = 1000000;
+        npc.life = NPCLife::pack(true, 100);
+        npc.moveDistance = 50;
+        npc.killDistance = 10;
+        npc.type = static_cast<uint8_t>(NPCType::DRAGON);
+        writer.put64(0x0102030405060708ull);
+        writer.putNPCs({npc, npc});
+        writer.putIds({1, 2, 3});
+        assert(writer.data().size() == 8 + 4 + 2 * WIRE_NPC_SIZE + 4 + 3 * 4);
+        assert(writer.data()[0] == 0x08 && writer.data()[7] == 0x01);
+        
+        WireReader reader(writer.data());
+        assert(reader.get64() == 0x0102030405060708ull);
+        std::vector<WireNPC> npcs;
+        reader.getNPCs(npcs);
+        assert(npcs.size() == 2 && npcs[1].id == 7 && npcs[1].x == -3 && npcs[1].y == 1000000);
+        assert(npcs[1].life == npc.life && npcs[1].killDistance == 10 && npcs[1].type == npc.type);
+        std::vector<uint32_t> ids;
+        reader.getIds(ids);
+        assert(ids.size() == 3 && ids[2] == 3 && reader.done());
+        bool truncated = false;
+        try {
+            reader.get8();
+        } catch (const std::runtime_error&) {
+            truncated = true;
+        }
+        assert(truncated);
+        
+        // Координатор и шарды в потоках одного процесса, но через сокеты
+        auto runCluster = [](int shards) {
+            ClusterConfig config;
+            config.shards = shards;
+            config.npcCount = 3000;
+            config.mapX = 900;
+            config.mapY = 300;
+            config.seed = 28;
+            config.ticks = 40;
+            config.socketPath = "lab07_test_cluster.sock";
+            ClusterCoordinator coordinator(config);
+            std::vector<std::thread> nodes;
+            for (int s = 0; s < shards; ++s) {
+                nodes.emplace_back([&config]() { ClusterShard(config.socketPath).run(); });
+            }
+            ClusterReport report = coordinator.run();
+            for (auto& t : nodes) t.join();
+            return report;
+        };
+        
+        ClusterReport first = runCluster(3);
+        ClusterReport second = runCluster(3);
+        assert(first.ticks == 40 && first.shards == 3);
+        assert(first.alive + first.dead == 3000);
+        assert(first.battlesFought > 0 && first.migrations > 0 && first.haloEntries > 0);
+        // Каждая смерть - ровно один бой; устаревшие убийства не считаются
+        assert(first.dead == first.battlesFought - first.staleKills);
+        // Прогон зависит только от сида и числа шардов
+        assert(first.alive == second.alive && first.battlesFought == second.battlesFought);
+        assert(first.migrations == second.migrations && first.aliveByType == second.aliveByType);
+        assert(first.bytesSent == second.bytesSent);
+        
+        ClusterReport single = runCluster(1);
+        assert(single.migrations == 0 && single.haloEntries == 0 && single.crossShardKills == 0);
+        assert(single.dead == single.battlesFought);
+        
+        // Полоса уже max killDistance - ореол не помещается у соседей
+        ClusterConfig narrow;
+        narrow.shards = 8;
+        narrow.npcCount = 100;
+        narrow.socketPath = "lab07_test_cluster.sock";
+        bool rejected = false;
+        try {
+            ClusterCoordinator coordinator(narrow);
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        assert(rejected);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 29: Гистограммы метрик и экспорт
+    std::cout << "Test 29: Metrics histograms and export... ";
+    {
+        // Квантиль гистограммы - с точностью до 1/32 значения
+        Histogram hist;
+        for (uint64_t v = 1; v <= 100000; ++v) hist.record(v);
+        assert(hist.count() == 100000 && hist.max() == 100000);
+        for (double q : {0.5, 0.9, 0.99, 0.999}) {
+            double exact = q * 100000;
+            double error = std::abs(static_cast<double>(hist.percentile(q)) - exact) / exact;
+            assert(error <= 1.0 / Histogram::SUB_BUCKETS);
+        }
+        for (uint64_t v : {0ull, 31ull, 32ull, 1000ull, 123456789ull}) {
+            assert(Histogram::bucketHigh(Histogram::bucketOf(v)) >= v);
+        }
+        Histogram other;
+        other.record(5000000);
+        hist.merge(other);
+        assert(hist.count() == 100001 && hist.max() == 5000000);
+        assert(hist.sum() == 100000ull * 100001 / 2 + 5000000);
+        
+        auto run = [](BattleScheduler scheduler, const char* path, MetricsFormat format) {
+            GameConfig config;
+            config.npcCount = 3000;
+            config.mapX = config.mapY = 200;
+            config.seed = 29;
+            config.battleScheduler = scheduler;
+            config.battleLog = LogDestination::DISCARD;
+            config.metricsPath = path;
+            config.metricsFormat = format;
+            std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+            Game game(config);
+            SimulationReport report = game.runHeadless(20);
+            std::cout.rdbuf(oldBuf);
+            return std::make_pair(report, game.metricsSnapshot());
+        };
+        auto readFile = [](const char* path) {
+            std::ifstream in(path);
+            return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        };
+        
+        auto rounds = run(BattleScheduler::ROUNDS, "lab07_test_metrics.prom",
+                          MetricsFormat::PROMETHEUS);
+        const RoleMetrics* movement = rounds.second.find("movement");
+        assert(movement && movement->threads == 1);
+        assert(movement->counter(CounterId::TICKS) == 20);
+        assert(movement->histogram(HistogramId::TICK).count() == 20);
+        assert(movement->counter(CounterId::PAIRS_TESTED) >= movement->counter(CounterId::PAIRS_FOUND));
+        assert(movement->counter(CounterId::BATTLES_ENQUEUED) == rounds.first.battlesSubmitted);
+        // Разобран каждый бой, но убийство засчитано не в каждом
+        assert(movement->counter(CounterId::BATTLES_RESOLVED) == rounds.first.battlesSubmitted);
+        assert(rounds.first.battlesFought <= rounds.first.battlesSubmitted);
+        assert(movement->histogram(HistogramId::NPCS_LOCK_WAIT).count() > 0);
+        // Финальная выгрузка после последнего тика
+        std::string text = readFile("lab07_test_metrics.prom");
+        assert(text.find("lab07_ticks_total{role=\"movement\"} 20\n") != std::string::npos);
+        assert(text.find("lab07_tick_seconds{role=\"movement\",quantile=\"0.99\"}") != std::string::npos);
+        
+        // В пуле бои считает поток боя; не вошедшие в очередь и
+        // отброшенные после сжатия не в счет
+        auto pool = run(BattleScheduler::POOL, "lab07_test_metrics.json", MetricsFormat::JSON);
+        const RoleMetrics* battle = pool.second.find("battle");
+        movement = pool.second.find("movement");
+        assert(battle && movement && movement->threads == 1);
+        assert(battle->counter(CounterId::BATTLES_RESOLVED) + pool.first.battlesStale ==
+               movement->counter(CounterId::BATTLES_ENQUEUED));
+        assert(battle->histogram(HistogramId::BATTLE).count() == battle->counter(CounterId::BATTLES_RESOLVED));
+        assert(movement->histogram(HistogramId::QUEUE_DEPTH).count() == 20);
+        text = readFile("lab07_test_metrics.json");
+        assert(text.find("{\"roles\":[") == 0 && text.find("\"role\":\"battle\"") != std::string::npos);
+        assert(text.find("\"ticks_total\":20") != std::string::npos);
+        std::remove("lab07_test_metrics.prom");
+        std::remove("lab07_test_metrics.json");
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 30: Уплотнение мертвых NPC и поколения хэндлов
+    std::cout << "Test 30: Dead-NPC compaction and handle generations... ";
+    {
+        World world;
+        for (int i = 0; i < 5; ++i) world.add(Orc("Orc" + std::to_string(i), i * 10, i));
+        NPCHandle fourth = world.handle(4);
+        world.kill(world.handle(1));
+        world.kill(world.handle(3));
+        
+        assert(world.compact() == 2 && world.size() == 3 && world.removed() == 2);
+        assert(world.generation() == 1 && world.generation() != fourth.generation);
+        // Старый дескриптор отвергается, новый указывает на того же NPC
+        assert(!world.current(fourth));
+        NPCHandle moved = world.handle(2);
+        assert(world.current(moved) && world.stableId(moved) == 4);
+        assert(world.getName(moved) == "Orc4" && world.getX(moved) == 40 && world.getY(moved) == 4);
+        assert(world.xs()[1] == 20 && world.isAlive(size_t{1}));
+        assert(world.compact() == 0 && world.generation() == 1);
+        
+        // Пауза пула: задачи ждут в очереди, обработчик не вызывается
+        std::atomic<int> handled{0};
+        BattlePool pool(2, 64, [&handled](const BattleTask&) { handled++; });
+        pool.pause();
+        for (uint32_t i = 0; i < 10; ++i) assert(pool.submit({NPCHandle{i}, NPCHandle{i + 1}}));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        assert(handled == 0 && pool.queued() == 10);
+        pool.resume();
+        pool.waitIdle();
+        assert(handled == 10);
+        pool.stop();
+        
+        // Сжатие сохраняет порядок живых: при одном куске движения
+        // прогон совпадает с прогоном без сжатия, вместе с журналом
+        auto run = [](double ratio, const char* logPath) {
+            GameConfig config;
+            config.npcCount = 3000;
+            config.mapX = config.mapY = 300;
+            config.seed = 30;
+            config.movementThreads = 2;
+            config.compactDeadRatio = ratio;
+            config.battleLog = LogDestination::FILE;
+            config.battleLogPath = logPath;
+            std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+            SimulationReport report;
+            {
+                Game game(config);
+                report = game.runHeadless(40);
+            }
+            std::cout.rdbuf(oldBuf);
+            std::ifstream in(logPath);
+            std::vector<std::string> lines;
+            for (std::string line; std::getline(in, line); ) lines.push_back(line);
+            std::sort(lines.begin(), lines.end());
+            std::remove(logPath);
+            return std::make_pair(report, lines);
+        };
+        auto plain = run(0, "lab07_test_plain.log");
+        auto compacted = run(0.1, "lab07_test_compacted.log");
+        assert(plain.first.compactions == 0 && compacted.first.compactions > 0);
+        assert(plain.first.alive == compacted.first.alive && plain.first.dead == compacted.first.dead);
+        assert(plain.first.battlesFought == compacted.first.battlesFought);
+        assert(plain.first.aliveByType == compacted.first.aliveByType);
+        assert(compacted.first.dead == compacted.first.battlesFought);
+        assert(!plain.second.empty() && plain.second == compacted.second);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 31: Счетчики живых и рендер карты по разнице
+    std::cout << "Test 31: Live counters and diff-based map renderer... ";
+    {
+        // Символы типов различны, иначе карту не прочитать
+        for (size_t a = 0; a < NPC_TYPE_COUNT; ++a) {
+            for (size_t b = a + 1; b < NPC_TYPE_COUNT; ++b) {
+                assert(NPC_TRAITS[a].symbol != NPC_TRAITS[b].symbol);
+            }
+        }
+        assert(MapRenderer::cellSymbol(0) == '.');
+        assert(MapRenderer::cellSymbol(1u << static_cast<int>(NPCType::DRAGON)) == 'D');
+        assert(MapRenderer::cellSymbol(0x0101) == '*');
+        
+        // Карта снимка уменьшена до клеток и строится только по живым
+        World world;
+        NPCHandle orc = world.add(Orc("GridOrc", 0, 0));
+        world.add(Elf("GridElf", 99, 99));
+        world.add(Dragon("GridDragon", 10, 5));
+        NPCHandle dead = world.add(Bear("GridBear", 60, 10));
+        world.kill(dead);
+        SnapshotPublisher publisher;
+        publisher.setGrid(4, 2);
+        publisher.publish(world, 1, 100, 100);
+        auto snap = publisher.acquire();
+        assert(snap->gridCols == 4 && snap->gridRows == 2 && snap->grid.size() == 8);
+        assert(snap->grid[0] == ((1u << static_cast<int>(NPCType::ORC)) |
+                                 (1u << static_cast<int>(NPCType::DRAGON))));
+        assert(snap->grid[7] == 1u << static_cast<int>(NPCType::ELF));
+        assert(snap->grid[2] == 0);
+        
+        MapStatus status;
+        status.tick = 1;
+        status.alive = 3;
+        status.dead = 1;
+        
+        MapRenderer text(4, 2, MapStyle::TEXT);
+        std::string frame = text.render(*snap, status);
+        assert(frame.find("|*...|\n|...E|\n") != std::string::npos);
+        assert(frame.find("Alive: 3  Dead: 1") != std::string::npos);
+        
+        // ANSI: первый кадр целиком, потом только отличия
+        MapRenderer ansi(4, 2, MapStyle::ANSI);
+        frame = ansi.render(*snap, status);
+        assert(frame.find("\x1b[H\x1b[2J") == 0 && ansi.changedCells() > 0);
+        frame = ansi.render(*snap, status);
+        assert(ansi.changedCells() == 0 && frame == "\x1b[" + std::to_string(ansi.height() + 1) + ";1H");
+        
+        world.kill(orc);
+        publisher.publish(world, 2, 100, 100);
+        status.tick = 2;
+        frame = ansi.render(*publisher.acquire(), status);
+        assert(frame.find("\x1b[2J") == std::string::npos);
+        assert(ansi.changedCells() == 2);  // цифра тика и клетка (0, 0): '*' -> 'D'
+        assert(frame.find('D') != std::string::npos);
+        
+        // Счетчики игры ведутся по убийствам и совпадают с полным подсчетом
+        GameConfig config;
+        config.npcCount = 2000;
+        config.mapX = config.mapY = 200;
+        config.seed = 31;
+        config.battleLog = LogDestination::DISCARD;
+        std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+        Game game(config);
+        MapStatus before = game.liveStatus();
+        SimulationReport report = game.runHeadless(20);
+        std::cout.rdbuf(oldBuf);
+        MapStatus after = game.liveStatus();
+        assert(before.alive == 2000 && before.dead == 0);
+        assert(after.alive == report.alive && after.dead == report.dead);
+        assert(after.aliveByType == report.aliveByType && after.battles == report.battlesFought);
+    }
+    std::cout << "PASSED ✓\n";
+    
+    // Тест 32: Сжатый журнал событий, реплей и перемотка
+    std::cout << "Test 32: Compressed event journal, replay and seek... ";
+    {
+        // Блочное сжатие: повторы сжимаются, порча данных обнаруживается
+        std::vector<uint8_t> raw;
+        for (int i = 0; i < 5000; ++i) raw.push_back(static_cast<uint8_t>(i % 7 == 0 ? i / 700 : i % 13));
+        std::vector<uint8_t> packed, unpacked;
+        lzCompress(raw.data(), raw.size(), packed);
+        assert(packed.size() < raw.size() / 2);
+        lzDecompress(packed.data(), packed.size(), raw.size(), unpacked);
+        assert(unpacked == raw);
+        bool threw = false;
+        try {
+            unpacked.clear();
+            lzDecompress(packed.data(), packed.size(), raw.size() + 1, unpacked);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+        
+        // varint и zigzag
+        WireWriter vw;
+        vw.putVar(0);
+        vw.putVar(300);
+        vw.putVar(UINT64_MAX);
+        vw.putSignedVar(-1);
+        vw.putSignedVar(-100000);
+        assert(vw.size() == 1 + 2 + 10 + 1 + 3);
+        WireReader vr(vw.data());
+        assert(vr.getVar() == 0 && vr.getVar() == 300 && vr.getVar() == UINT64_MAX);
+        assert(vr.getSignedVar() == -1 && vr.getSignedVar() == -100000);
+        
+        // Запись недетерминированного прогона (пул боев) и его воспроизведение
+        const std::string path = "lab07_test_journal.bin";
+        GameConfig config;
+        config.npcCount = 2000;
+        config.mapX = config.mapY = 200;
+        config.seed = 32;
+        config.battleLog = LogDestination::DISCARD;
+        config.battleScheduler = BattleScheduler::POOL;
+        config.battleWorkers = 4;
+        config.journalPath = path;
+        config.keyframeTicks = 10;
+        std::streambuf* oldBuf = std::cout.rdbuf(nullptr);
+        SimulationReport recorded;
+        std::shared_ptr<const WorldSnapshot> recordedSnap;
+        {
+            Game game(config);
+            recorded = game.runHeadless(60);
+            recordedSnap = game.snapshot();
+        }
+        
+        GameConfig replayConfig;
+        replayConfig.battleLog = LogDestination::DISCARD;
+        replayConfig.replayPath = path;
+        Game replayGame(replayConfig);
+        SimulationReport replayed = replayGame.runHeadless(1000);
+        std::cout.rdbuf(oldBuf);
+        assert(recorded.journalTicks == 60 && recorded.journalBytes < recorded.journalRawBytes);
+        assert(replayed.ticks == 60);
+        assert(replayed.alive == recorded.alive && replayed.aliveByType == recorded.aliveByType);
+        assert(replayed.battlesFought == recorded.battlesFought);
+        
+        // Позиции живых по стабильным id (записанный мир мог быть сжат)
+        auto replaySnap = replayGame.snapshot();
+        assert(replaySnap->size() == 2000 && replaySnap->tick == recordedSnap->tick);
+        for (size_t i = 0; i < recordedSnap->size(); ++i) {
+            if (!recordedSnap->isAlive(i)) continue;
+            const NPCId id = recordedSnap->statics->id[i];
+            assert(replaySnap->isAlive(id));
+            assert(replaySnap->x[id] == recordedSnap->x[i] && replaySnap->y[id] == recordedSnap->y[i]);
+        }
+        
+        // Перемотка к тику совпадает с воспроизведением с начала
+        JournalReader full(path);
+        assert(full.keyframes() == 7 && full.lastTick() == full.firstTick() + 60);
+        const uint64_t mid = full.firstTick() + 37;
+        World stepped = full.seek(full.firstTick());
+        JournalTick step;
+        while (full.next(step)) {
+            JournalReader::applyMoves(stepped, step);
+            for (const BattleRecord& rec : step.battles) {
+                stepped.tryKill(stepped.handle(rec.attackerWins ? rec.defender : rec.attacker));
+            }
+            if (step.tick == mid) break;
+        }
+        JournalReader seeker(path);
+        World sought = seeker.seek(mid);
+        // (позиции мертвых ключевой кадр не хранит)
+        assert(sought.size() == stepped.size());
+        for (size_t i = 0; i < sought.size(); ++i) {
+            assert(sought.lifeWord(i) == stepped.lifeWord(i));
+            if (!sought.isAlive(i)) continue;
+            assert(sought.xs()[i] == stepped.xs()[i] && sought.ys()[i] == stepped.ys()[i]);
+        }
+        assert(seeker.next(step) && step.tick == mid + 1);
+        
+        // Оборванный хвост: читается до последнего целого блока
+        {
+            std::ifstream in(path, std::ios::binary);
+            std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 5));
+        }
+        JournalReader truncated(path);
+        assert(truncated.keyframes() == full.keyframes() - 1);  // последний блок - кадр тика 60
+        assert(truncated.lastTick() == full.lastTick());
+        std::remove(path.c_str());
+    }
+    std::cout << "PASSED ✓\n";
+    
+    std::cout << "\n=== All 32 tests PASSED! ===\n";
 }
 
 int main() {
@@ -0,0 +1,236 @@
+#include "shards.h"
+#include "kill_kernel.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <thread>
+
+ShardedBroadphase::ShardedBroadphase(size_t shardCount)
+    : pool(std::min<size_t>(shardCount > 0 ? shardCount : SIZE_MAX,
+                            std::max(1u, std::thread::hardware_concurrency()))),
+      shards(shardCount > 0 ? shardCount : pool.size()) {}
+
+size_t ShardedBroadphase::shardFor(int x) const {
+    if (x < 0) return 0;
+    return std::min(static_cast<size_t>(x / stripWidth), active - 1);
+}
+
+// Полное перераспределение: новый мир, новая карта, новые NPC или сжатие
+void ShardedBroadphase::layout(const World& world, int mapX, int mapY) {
+    const auto& kill = world.killDistances();
+    halo = 1;
+    for (size_t i = 0; i < world.size(); ++i) halo = std::max(halo, kill[i]);
+
+    mapX = std::max(mapX, 1);
+    active = std::min(shards.size(), static_cast<size_t>(std::max(1, mapX / halo)));
+    stripWidth = (mapX + static_cast<int>(active) - 1) / static_cast<int>(active);
+
+    for (size_t s = 0; s < shards.size(); ++s) {
+        Shard& shard = shards[s];
+        shard.x0 = s == 0 ? INT_MIN : stripBegin(s);
+        shard.x1 = s + 1 >= active ? INT_MAX : stripEnd(s);
+        shard.owned.clear();
+        shard.leaving.clear();
+    }
+    const auto& xs = world.xs();
+    for (size_t i = 0; i < world.size(); ++i) {
+        if (world.isAlive(i)) shards[shardFor(xs[i])].owned.push_back(static_cast<NPCId>(i));
+    }
+
+    builtSize = world.size();
+    builtGeneration = world.generation();
+    builtMapX = mapX;
+    builtMapY = mapY;
+    counters.rebuilds++;
+}
+
+// Фаза 1: мертвых выбрасываем (они не оживают), ушедших - в leaving
+void ShardedBroadphase::releaseMigrants(Shard& shard, size_t s, const World& world) {
+    const auto& xs = world.xs();
+    shard.leaving.clear();
+    size_t kept = 0;
+    for (NPCId id : shard.owned) {
+        if (!world.isAlive(id)) continue;
+        if (shardFor(xs[id]) != s) {
+            shard.leaving.push_back(id);
+        } else {
+            shard.owned[kept++] = id;
+        }
+    }
+    shard.owned.resize(kept);
+}
+
+// Фаза 2: забираем своих из leaving всех шардов и отмечаем NPC у
+// границ - это ореол, который на фазе 3 прочитают соседи
+void ShardedBroadphase::adoptMigrants(Shard& shard, size_t s, const World& world) {
+    const auto& xs = world.xs();
+    shard.migrated = 0;
+    for (size_t t = 0; t < active; ++t) {
+        if (t == s) continue;
+        for (NPCId id : shards[t].leaving) {
+            if (shardFor(xs[id]) == s) {
+                shard.owned.push_back(id);
+                shard.migrated++;
+            }
+        }
+    }
+
+    shard.edgeLow.clear();
+    shard.edgeHigh.clear();
+    const bool hasLow = s > 0;
+    const bool hasHigh = s + 1 < active;
+    for (NPCId id : shard.owned) {
+        if (hasLow && xs[id] < shard.x0 + halo) shard.edgeLow.push_back(id);
+        if (hasHigh && xs[id] >= shard.x1 - halo) shard.edgeHigh.push_back(id);
+    }
+}
+
+// Фаза 3: своя сетка по bounding box шарда с ореолом
+void ShardedBroadphase::findLocalPairs(Shard& shard, size_t s, const World& world) {
+    const auto& xs = world.xs();
+    const auto& ys = world.ys();
+    const auto& kill = world.killDistances();
+
+    shard.localId.clear();
+    shard.localX.clear();
+    shard.localY.clear();
+    shard.pairs.clear();
+    auto gather = [&](const std::vector<NPCId>& ids) {
+        for (NPCId id : ids) {
+            if (!world.isAlive(id)) continue;
+            shard.localId.push_back(id);
+            shard.localX.push_back(xs[id]);
+            shard.localY.push_back(ys[id]);
+        }
+    };
+    gather(shard.owned);
+    const size_t ownedCount = shard.localId.size();
+    if (s > 0) gather(shards[s - 1].edgeHigh);
+    if (s + 1 < active) gather(shards[s + 1].edgeLow);
+    const size_t count = shard.localId.size();
+    shard.haloSize = count - ownedCount;
+    shard.tested = 0;
+    if (ownedCount == 0 || count < 2) return;
+
+    int minX = INT_MAX, maxX = INT_MIN, minY = INT_MAX, maxY = INT_MIN;
+    for (size_t k = 0; k < count; ++k) {
+        minX = std::min(minX, shard.localX[k]);
+        maxX = std::max(maxX, shard.localX[k]);
+        minY = std::min(minY, shard.localY[k]);
+        maxY = std::max(maxY, shard.localY[k]);
+    }
+
+    // Ячейка не меньше halo: цели NPC лежат в соседних 3x3 ячейках.
+    // Как и у общей сетки, ячеек не больше 4 на NPC.
+    const long long spanX = static_cast<long long>(maxX) - minX + 1;
+    const long long spanY = static_cast<long long>(maxY) - minY + 1;
+    int cellSize = halo;
+    const double maxCells = std::max<double>(1024.0, 4.0 * count);
+    if (static_cast<double>(spanX / cellSize + 1) * (spanY / cellSize + 1) > maxCells) {
+        cellSize = std::max(cellSize, static_cast<int>(std::ceil(
+            std::sqrt(static_cast<double>(spanX) * spanY / maxCells))));
+    }
+    const int gridW = static_cast<int>(spanX / cellSize) + 1;
+    const int gridH = static_cast<int>(spanY / cellSize) + 1;
+    const size_t cellCount = static_cast<size_t>(gridW) * gridH;
+
+    shard.cellStart.assign(cellCount + 1, 0);
+    shard.localCell.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t c = static_cast<uint32_t>((shard.localY[k] - minY) / cellSize * gridW +
+                                           (shard.localX[k] - minX) / cellSize);
+        shard.localCell[k] = c;
+        shard.cellStart[c + 1]++;
+    }
+    for (size_t c = 0; c < cellCount; ++c) shard.cellStart[c + 1] += shard.cellStart[c];
+    shard.cellEntries.resize(count);
+    shard.cellX.resize(count);
+    shard.cellY.resize(count);
+    std::vector<uint32_t> fill(shard.cellStart.begin(), shard.cellStart.end() - 1);
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t slot = fill[shard.localCell[k]]++;
+        shard.cellEntries[slot] = static_cast<uint32_t>(k);
+        shard.cellX[slot] = shard.localX[k];
+        shard.cellY[slot] = shard.localY[k];
+    }
+
+    // Атакующие - только свои NPC; цели - свои и ореол
+    for (size_t k = 0; k < ownedCount; ++k) {
+        const NPCId id = shard.localId[k];
+        const int cx = static_cast<int>(shard.localCell[k] % gridW);
+        const int cy = static_cast<int>(shard.localCell[k] / gridW);
+
+        for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, gridH - 1); ++ny) {
+            for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, gridW - 1); ++nx) {
+                const size_t c = static_cast<size_t>(ny) * gridW + nx;
+                const uint32_t end = shard.cellStart[c + 1];
+                for (uint32_t block = shard.cellStart[c]; block < end; block += KILL_BLOCK) {
+                    size_t n = std::min<size_t>(KILL_BLOCK, end - block);
+                    shard.tested += n;
+                    uint32_t hits = killMask(shard.localX[k], shard.localY[k], kill[id],
+                                             &shard.cellX[block], &shard.cellY[block], n);
+                    while (hits) {
+                        NPCId j = shard.localId[shard.cellEntries[block + lowestBit(hits)]];
+                        hits &= hits - 1;
+                        if (j > id) shard.pairs.push_back({id, j});
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort(shard.pairs.begin(), shard.pairs.end(), [](const BattlePair& a, const BattlePair& b) {
+        return a.attacker != b.attacker ? a.attacker < b.attacker
+                                        : a.defender < b.defender;
+    });
+
+    // Атакующим владеет один шард, поэтому счетчики пишутся без гонок
+    for (const BattlePair& p : shard.pairs) pairOffset[p.attacker]++;
+}
+
+void ShardedBroadphase::findPairs(const World& world,
+                                  int mapX, int mapY,
+                                  std::vector<BattlePair>& out) {
+    counters.calls++;
+    if (world.size() != builtSize || world.generation() != builtGeneration ||
+        std::max(mapX, 1) != builtMapX || mapY != builtMapY) {
+        layout(world, mapX, mapY);
+    }
+    pairOffset.assign(world.size() + 1, 0);
+
+    auto phase = [this, &world](void (ShardedBroadphase::*step)(Shard&, size_t, const World&)) {
+        pool.parallelFor(active, 1, [&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; ++s) (this->*step)(shards[s], s, world);
+        });
+    };
+    phase(&ShardedBroadphase::releaseMigrants);
+    phase(&ShardedBroadphase::adoptMigrants);
+    phase(&ShardedBroadphase::findLocalPairs);
+
+    // Фаза 4: пары атакующего лежат подряд в его шарде; раскладываем
+    // их по смещениям в порядке атакующих - как у полного перебора
+    uint32_t total = 0;
+    for (size_t i = 0; i < world.size(); ++i) {
+        uint32_t n = pairOffset[i];
+        pairOffset[i] = total;
+        total += n;
+    }
+    out.resize(total);
+    pool.parallelFor(active, 1, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; ++s) {
+            const std::vector<BattlePair>& pairs = shards[s].pairs;
+            for (size_t k = 0; k < pairs.size(); ) {
+                BattlePair* dst = out.data() + pairOffset[pairs[k].attacker];
+                const uint32_t attacker = pairs[k].attacker;
+                for (; k < pairs.size() && pairs[k].attacker == attacker; ++k) *dst++ = pairs[k];
+            }
+        }
+    });
+
+    counters.shards = active;
+    for (size_t s = 0; s < active; ++s) {
+        counters.migrations += shards[s].migrated;
+        counters.haloEntries += shards[s].haloSize;
+        counters.candidatesChecked += shards[s].tested;
+    }
+}
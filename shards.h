@@ -0,0 +1,85 @@
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include "broadphase.h"
+#include "thread_pool.h"
+#include <cstdint>
+#include <vector>
+
+// Поиск пар на больших картах по пространственным шардам. Карта делится
+// по x на полосы, каждой полосой владеет шард со своим списком NPC.
+// Тик идет фазами на пуле потоков, между фазами - барьер:
+//   1) шард выбрасывает мертвых и отдает NPC, ушедших из полосы;
+//   2) шард забирает пришедших к нему (миграция) и отмечает своих NPC
+//      не дальше halo = max killDistance от границ полосы;
+//   3) шард ищет пары своей сеткой среди своих NPC и ореола - NPC
+//      соседей, отмеченных у общей границы на фазе 2;
+//   4) пары шардов раскладываются в общий список.
+// Пару (i, j), i < j, выдает владелец i: все цели i не дальше
+// killDistance_i <= halo, то есть среди своих или в ореоле. Каждая пара
+// найдена ровно один раз, и порядок пар - как у полного перебора, при
+// любом числе шардов.
+//
+// Сжатие мира (новое поколение) перенумеровывает NPC - это тоже
+// полное перераспределение.
+//
+// Полоса не уже halo, иначе ореол пришлось бы брать не только у
+// соседей; на узкой карте шардов меньше запрошенного.
+class ShardedBroadphase : public Broadphase {
+public:
+    // shardCount = 0 - по числу ядер
+    explicit ShardedBroadphase(size_t shardCount = 0);
+
+    void findPairs(const World& world,
+                   int mapX, int mapY,
+                   std::vector<BattlePair>& out) override;
+
+    const char* name() const override { return "sharded"; }
+    BroadphaseStats stats() const override { return counters; }
+
+    // Шарды после последнего findPairs: полоса [stripBegin, stripEnd) и NPC
+    size_t shardCount() const { return active; }
+    int stripBegin(size_t shard) const { return static_cast<int>(shard) * stripWidth; }
+    int stripEnd(size_t shard) const { return stripBegin(shard) + stripWidth; }
+    const std::vector<NPCId>& owned(size_t shard) const { return shards[shard].owned; }
+    size_t shardFor(int x) const;
+
+private:
+    struct Shard {
+        int x0 = 0, x1 = 0;          // полоса [x0, x1); у крайних открыта наружу
+        std::vector<NPCId> owned;
+        std::vector<NPCId> leaving;  // ушли из полосы в этом тике
+        std::vector<NPCId> edgeLow;  // у x0 - ореол левого соседа
+        std::vector<NPCId> edgeHigh; // у x1 - ореол правого соседа
+
+        // Свои NPC (первые ownedCount) и ореол, сетка по ним в CSR-виде
+        std::vector<NPCId> localId;
+        std::vector<int> localX, localY;
+        std::vector<uint32_t> localCell;
+        std::vector<uint32_t> cellStart, cellEntries;
+        std::vector<int> cellX, cellY;
+        std::vector<BattlePair> pairs;
+
+        uint64_t migrated = 0;
+        uint64_t haloSize = 0;
+        uint64_t tested = 0;
+    };
+
+    ThreadPool pool;
+    std::vector<Shard> shards;
+    size_t active = 1;
+    int stripWidth = 1;
+    int halo = 1;
+    size_t builtSize = 0;
+    uint32_t builtGeneration = 0;
+    int builtMapX = 0, builtMapY = 0;
+    std::vector<uint32_t> pairOffset;  // начало пар атакующего в out
+    BroadphaseStats counters;
+
+    void layout(const World& world, int mapX, int mapY);
+    void releaseMigrants(Shard& shard, size_t s, const World& world);
+    void adoptMigrants(Shard& shard, size_t s, const World& world);
+    void findLocalPairs(Shard& shard, size_t s, const World& world);
+};
+
+#endif
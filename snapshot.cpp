@@ -0,0 +1,72 @@
+#include "snapshot.h"
+#include <algorithm>
+#include <atomic>
+
+NPC WorldSnapshot::view(size_t i) const {
+    NPC npc(statics->name(i), statics->type[i], x[i], y[i], health[i],
+            statics->moveDistance[i], statics->killDistance[i]);
+    if (!alive[i]) {
+        npc.kill();
+    }
+    return npc;
+}
+
+void SnapshotPublisher::publish(const World& world, uint64_t tick, int mapX, int mapY) {
+    // Буферы снимка, который уже никто не читает, используем заново
+    std::shared_ptr<WorldSnapshot> next;
+    if (spare && spare.use_count() == 1) {
+        // Парный барьер к освобождению ссылки последним читателем
+        std::atomic_thread_fence(std::memory_order_acquire);
+        next = std::move(spare);
+    } else {
+        next = std::make_shared<WorldSnapshot>();
+    }
+
+    next->tick = tick;
+    next->mapX = mapX;
+    next->mapY = mapY;
+    next->x.assign(world.xs().begin(), world.xs().end());
+    next->y.assign(world.ys().begin(), world.ys().end());
+    // Жизнь читается по слову: жив и здоровье всегда согласованы
+    const size_t count = world.size();
+    next->alive.resize(count);
+    next->health.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t word = world.lifeWord(i);
+        next->alive[i] = NPCLife::alive(word) ? 1 : 0;
+        next->health[i] = NPCLife::health(word);
+    }
+
+    next->gridCols = gridCols;
+    next->gridRows = gridRows;
+    next->grid.assign(static_cast<size_t>(gridCols) * gridRows, 0);
+    if (gridCols > 0 && gridRows > 0) {
+        const auto& types = world.types();
+        const long long spanX = std::max(mapX, 1);
+        const long long spanY = std::max(mapY, 1);
+        for (size_t i = 0; i < count; ++i) {
+            if (!next->alive[i]) continue;
+            long long col = std::min<long long>(std::max(next->x[i], 0) * gridCols / spanX, gridCols - 1);
+            long long row = std::min<long long>(std::max(next->y[i], 0) * gridRows / spanY, gridRows - 1);
+            next->grid[static_cast<size_t>(row * gridCols + col)] |=
+                static_cast<uint16_t>(1u << static_cast<unsigned>(types[i]));
+        }
+    }
+    next->statics = world.sharedStatics();
+    next->removed = world.removed();
+
+    std::shared_ptr<const WorldSnapshot> previous = std::atomic_load(&current);
+    std::atomic_store(&current, std::shared_ptr<const WorldSnapshot>(next));
+
+    // Предыдущий снимок станет запасным, когда его отпустят читатели
+    spare = std::const_pointer_cast<WorldSnapshot>(previous);
+}
+
+void SnapshotPublisher::setGrid(int cols, int rows) {
+    gridCols = std::max(cols, 0);
+    gridRows = std::max(rows, 0);
+}
+
+std::shared_ptr<const WorldSnapshot> SnapshotPublisher::acquire() const {
+    return std::atomic_load(&current);
+}
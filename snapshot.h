@@ -0,0 +1,63 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "world.h"
+#include "npc.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Неизменяемый снимок мира на границе тика. Наблюдатели (printMap,
+// printSurvivors, экспорт) читают его без блокировки мира.
+static_assert(NPC_TYPE_COUNT <= 16, "WorldSnapshot::grid keeps a 16-bit type mask");
+
+struct WorldSnapshot {
+    uint64_t tick = 0;
+    int mapX = 0;
+    int mapY = 0;
+
+    std::vector<int> x, y;
+    std::vector<uint8_t> alive;
+    std::vector<int> health;
+    std::shared_ptr<const NPCStatics> statics;
+    size_t removed = 0;  // мертвых, удаленных из мира сжатием (в x, y их нет)
+
+    // Карта живых, уменьшенная до gridCols x gridRows клеток (если
+    // включена в SnapshotPublisher): в клетке - маска типов NPC
+    int gridCols = 0;
+    int gridRows = 0;
+    std::vector<uint16_t> grid;
+
+    size_t size() const { return x.size(); }
+    bool isAlive(size_t i) const { return alive[i] != 0; }
+    std::string getName(size_t i) const { return statics->name(i); }
+    NPCType getType(size_t i) const { return statics->type[i]; }
+
+    // Копия NPC для toString
+    NPC view(size_t i) const;
+};
+
+// Публикация снимков в стиле RCU: писатель подменяет указатель на новый
+// снимок, читатели атомарно берут ссылку на текущий и держат его сколько
+// нужно. Старый снимок освобождается вместе с последним читателем.
+class SnapshotPublisher {
+private:
+    std::shared_ptr<const WorldSnapshot> current;
+    std::shared_ptr<WorldSnapshot> spare;  // для повторного использования буферов
+    int gridCols = 0;
+    int gridRows = 0;
+
+public:
+    // Собирать в снимках карту cols x rows (0 - не собирать). Карта
+    // строится в том же проходе, что и копия жизни, поэтому вывод не
+    // зависит от числа NPC. Вызывать до потоков, публикующих снимки.
+    void setGrid(int cols, int rows);
+
+    // Снимок текущего состояния world (вызывать под блокировкой мира)
+    void publish(const World& world, uint64_t tick, int mapX, int mapY);
+
+    // Текущий снимок (может быть nullptr до первой публикации)
+    std::shared_ptr<const WorldSnapshot> acquire() const;
+};
+
+#endif
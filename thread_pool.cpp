@@ -0,0 +1,88 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) {
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCV.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const RangeFn& fn) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    // Мало работы или нет потоков - выполняем на месте
+    if (workers.empty() || count <= grain) {
+        nextChunk = 0;
+        runChunks(fn, count, grain);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobCount = count;
+        jobGrain = grain;
+        nextChunk = 0;
+        finishedWorkers = 0;
+        generation++;
+    }
+    startCV.notify_all();
+
+    runChunks(fn, count, grain);
+
+    // Ждем всех: после возврата никто не должен обращаться к fn
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCV.wait(lock, [this]() { return finishedWorkers == workers.size(); });
+    job = nullptr;
+}
+
+void ThreadPool::runChunks(const RangeFn& fn, size_t count, size_t grain) {
+    const size_t chunks = (count + grain - 1) / grain;
+    for (;;) {
+        size_t chunk = nextChunk.fetch_add(1);
+        if (chunk >= chunks) break;
+
+        size_t begin = chunk * grain;
+        fn(begin, std::min(begin + grain, count));
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seenGeneration = 0;
+
+    for (;;) {
+        const RangeFn* fn;
+        size_t count, grain;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCV.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+
+            seenGeneration = generation;
+            fn = job;
+            count = jobCount;
+            grain = jobGrain;
+        }
+
+        runChunks(*fn, count, grain);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finishedWorkers++;
+        }
+        doneCV.notify_one();
+    }
+}
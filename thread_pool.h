@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков для параллельных циклов по данным мира. Вызывающий поток
+// тоже участвует в работе, так что пул размера 1 не создает потоков.
+// parallelFor вызывается из одного потока за раз.
+class ThreadPool {
+public:
+    // Обработчик куска [begin, end); куски всегда выровнены по grain,
+    // поэтому begin / grain - стабильный номер куска
+    using RangeFn = std::function<void(size_t begin, size_t end)>;
+
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Делит [0, count) на куски по grain и выполняет fn на всех потоках.
+    // Возвращается, когда обработаны все куски.
+    void parallelFor(size_t count, size_t grain, const RangeFn& fn);
+
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable startCV;
+    std::condition_variable doneCV;
+
+    const RangeFn* job = nullptr;
+    size_t jobCount = 0;
+    size_t jobGrain = 1;
+    std::atomic<size_t> nextChunk{0};
+    uint64_t generation = 0;
+    size_t finishedWorkers = 0;
+    bool stopping = false;
+
+    void workerLoop();
+    void runChunks(const RangeFn& fn, size_t count, size_t grain);
+};
+
+#endif
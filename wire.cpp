@@ -0,0 +1,266 @@
+#include "wire.h"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // нет на macOS
+#endif
+#endif
+
+void WireWriter::put16(uint16_t v) {
+    put8(static_cast<uint8_t>(v));
+    put8(static_cast<uint8_t>(v >> 8));
+}
+
+void WireWriter::put32(uint32_t v) {
+    put16(static_cast<uint16_t>(v));
+    put16(static_cast<uint16_t>(v >> 16));
+}
+
+void WireWriter::put64(uint64_t v) {
+    put32(static_cast<uint32_t>(v));
+    put32(static_cast<uint32_t>(v >> 32));
+}
+
+void WireWriter::putNPC(const WireNPC& npc) {
+    put32(npc.id);
+    put32(static_cast<uint32_t>(npc.x));
+    put32(static_cast<uint32_t>(npc.y));
+    put32(npc.life);
+    put16(npc.moveDistance);
+    put16(npc.killDistance);
+    put8(npc.type);
+    put8(0);
+    put16(0);
+}
+
+void WireWriter::putNPCs(const std::vector<WireNPC>& npcs) {
+    put32(static_cast<uint32_t>(npcs.size()));
+    bytes.reserve(bytes.size() + npcs.size() * WIRE_NPC_SIZE);
+    for (const WireNPC& npc : npcs) putNPC(npc);
+}
+
+void WireWriter::putIds(const std::vector<uint32_t>& ids) {
+    put32(static_cast<uint32_t>(ids.size()));
+    for (uint32_t id : ids) put32(id);
+}
+
+void WireWriter::putVar(uint64_t v) {
+    while (v >= 0x80) {
+        put8(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    put8(static_cast<uint8_t>(v));
+}
+
+void WireWriter::putBytes(const void* data, size_t n) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    bytes.insert(bytes.end(), p, p + n);
+}
+
+const uint8_t* WireReader::take(size_t n) {
+    if (bytes.size() - pos < n) throw std::runtime_error("truncated wire data");
+    const uint8_t* p = bytes.data() + pos;
+    pos += n;
+    return p;
+}
+
+uint8_t WireReader::get8() {
+    return *take(1);
+}
+
+uint16_t WireReader::get16() {
+    const uint8_t* p = take(2);
+    return static_cast<uint16_t>(p[0] | p[1] << 8);
+}
+
+uint32_t WireReader::get32() {
+    uint32_t lo = get16();
+    uint32_t hi = get16();
+    return lo | hi << 16;
+}
+
+uint64_t WireReader::get64() {
+    uint64_t lo = get32();
+    uint64_t hi = get32();
+    return lo | hi << 32;
+}
+
+WireNPC WireReader::getNPC() {
+    WireNPC npc;
+    npc.id = get32();
+    npc.x = static_cast<int32_t>(get32());
+    npc.y = static_cast<int32_t>(get32());
+    npc.life = get32();
+    npc.moveDistance = get16();
+    npc.killDistance = get16();
+    npc.type = get8();
+    take(3);
+    return npc;
+}
+
+void WireReader::getNPCs(std::vector<WireNPC>& out) {
+    uint32_t count = get32();
+    if ((bytes.size() - pos) / WIRE_NPC_SIZE < count) {
+        throw std::runtime_error("truncated cluster message");
+    }
+    out.reserve(out.size() + count);
+    for (uint32_t i = 0; i < count; ++i) out.push_back(getNPC());
+}
+
+uint64_t WireReader::getVar() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t b = get8();
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    throw std::runtime_error("malformed varint");
+}
+
+void WireReader::getIds(std::vector<uint32_t>& out) {
+    uint32_t count = get32();
+    if ((bytes.size() - pos) / 4 < count) throw std::runtime_error("truncated cluster message");
+    out.reserve(out.size() + count);
+    for (uint32_t i = 0; i < count; ++i) out.push_back(get32());
+}
+
+#ifndef _WIN32
+
+static void sendAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throw std::runtime_error(std::string("cluster send failed: ") + std::strerror(errno));
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+static void recvAll(int fd, uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::recv(fd, data, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n == 0) throw std::runtime_error("cluster peer closed the connection");
+        if (n < 0) throw std::runtime_error(std::string("cluster recv failed: ") + std::strerror(errno));
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+size_t sendFrame(int fd, WireMessage type, uint64_t tick, const WireWriter& payload) {
+    const std::vector<uint8_t>& data = payload.data();
+    if (data.size() > WIRE_MAX_PAYLOAD) throw std::runtime_error("cluster message too large");
+
+    WireWriter header;
+    header.put32(static_cast<uint32_t>(data.size()));
+    header.put8(static_cast<uint8_t>(type));
+    header.put8(WIRE_VERSION);
+    header.put16(0);
+    header.put64(tick);
+    sendAll(fd, header.data().data(), WIRE_HEADER_SIZE);
+    if (!data.empty()) sendAll(fd, data.data(), data.size());
+    return WIRE_HEADER_SIZE + data.size();
+}
+
+size_t recvFrame(int fd, WireFrame& frame) {
+    std::vector<uint8_t> header(WIRE_HEADER_SIZE);
+    recvAll(fd, header.data(), header.size());
+
+    WireReader reader(header);
+    uint32_t size = reader.get32();
+    frame.type = static_cast<WireMessage>(reader.get8());
+    uint8_t version = reader.get8();
+    reader.get16();
+    frame.tick = reader.get64();
+    if (version != WIRE_VERSION) {
+        throw std::runtime_error("cluster protocol version " + std::to_string(version) +
+                                 ", expected " + std::to_string(WIRE_VERSION));
+    }
+    if (size > WIRE_MAX_PAYLOAD) throw std::runtime_error("cluster message too large");
+
+    frame.payload.resize(size);
+    if (size > 0) recvAll(fd, frame.payload.data(), size);
+    return WIRE_HEADER_SIZE + size;
+}
+
+static sockaddr_un unixAddress(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("socket path too long: " + path);
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+int listenUnix(const std::string& path, int backlog) {
+    sockaddr_un addr = unixAddress(path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(fd, backlog) < 0) {
+        int err = errno;
+        ::close(fd);
+        throw std::runtime_error("cannot listen on " + path + ": " + std::strerror(err));
+    }
+    return fd;
+}
+
+int acceptUnix(int listenFd) {
+    for (;;) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd >= 0) return fd;
+        if (errno != EINTR) throw std::runtime_error(std::string("accept: ") + std::strerror(errno));
+    }
+}
+
+int connectUnix(const std::string& path, int timeoutMillis) {
+    sockaddr_un addr = unixAddress(path);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMillis);
+    for (;;) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+        int err = errno;
+        ::close(fd);
+        if ((err != ENOENT && err != ECONNREFUSED) || std::chrono::steady_clock::now() >= deadline) {
+            throw std::runtime_error("cannot connect to " + path + ": " + std::strerror(err));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+void closeSocket(int fd) {
+    if (fd >= 0) ::close(fd);
+}
+
+#else
+
+// На Windows кластер недоступен: нужны Unix-сокеты
+size_t sendFrame(int, WireMessage, uint64_t, const WireWriter&) {
+    throw std::runtime_error("cluster mode needs POSIX sockets");
+}
+size_t recvFrame(int, WireFrame&) {
+    throw std::runtime_error("cluster mode needs POSIX sockets");
+}
+int listenUnix(const std::string&, int) {
+    throw std::runtime_error("cluster mode needs POSIX sockets");
+}
+int acceptUnix(int) {
+    throw std::runtime_error("cluster mode needs POSIX sockets");
+}
+int connectUnix(const std::string&, int) {
+    throw std::runtime_error("cluster mode needs POSIX sockets");
+}
+void closeSocket(int) {}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Двоичный протокол кластера шардов (cluster.h) поверх Unix-сокетов.
+// Все числа - little-endian независимо от машины. Кадр:
+//
+//   u32 длина данных | u8 тип | u8 версия | u16 0 | u64 тик | данные
+//
+// Списки NPC в данных - u32 число записей и записи WireNPC по 24 байта.
+//
+// WireWriter и WireReader кодируют и блоки журнала событий (journal.h).
+
+constexpr uint8_t WIRE_VERSION = 1;
+constexpr size_t WIRE_HEADER_SIZE = 16;
+constexpr size_t WIRE_NPC_SIZE = 24;
+constexpr uint32_t WIRE_MAX_PAYLOAD = 1u << 30;
+
+enum class WireMessage : uint8_t {
+    HELLO = 1,  // шард -> координатор: готов
+    ASSIGN,     // координатор -> шард: полоса, параметры и начальные NPC
+    STEP,       // координатор -> шард: начать тик; убийства своих NPC чужими боями
+    EXCHANGE,   // шард -> координатор: ушедшие из полосы и NPC у границ
+    HALO,       // координатор -> шард: пришедшие NPC и ореол соседей
+    REPORT,     // шард -> координатор: итоги боев тика, убийства чужих NPC
+    STOP,       // координатор -> шард: конец игры
+    FINAL       // шард -> координатор: живые NPC шарда
+};
+
+// NPC на проводе: все, что нужно шарду для движения и боев. Имена
+// остаются у координатора - шарды передают только номер NPC.
+struct WireNPC {
+    uint32_t id = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+    uint32_t life = 0;  // слово NPCLife
+    uint16_t moveDistance = 0;
+    uint16_t killDistance = 0;
+    uint8_t type = 0;
+};
+
+class WireWriter {
+public:
+    void put8(uint8_t v) { bytes.push_back(v); }
+    void put16(uint16_t v);
+    void put32(uint32_t v);
+    void put64(uint64_t v);
+    void putNPC(const WireNPC& npc);
+    void putNPCs(const std::vector<WireNPC>& npcs);
+    void putIds(const std::vector<uint32_t>& ids);
+
+    // LEB128 по 7 бит в байте; знаковые - через zigzag, чтобы малые по
+    // модулю числа занимали один байт
+    void putVar(uint64_t v);
+    void putSignedVar(int64_t v) {
+        putVar((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+    void putBytes(const void* data, size_t n);
+
+    const std::vector<uint8_t>& data() const { return bytes; }
+    size_t size() const { return bytes.size(); }
+    void clear() { bytes.clear(); }
+
+private:
+    std::vector<uint8_t> bytes;
+};
+
+// Чтение данных кадра; выход за конец - std::runtime_error
+class WireReader {
+public:
+    explicit WireReader(const std::vector<uint8_t>& bytes) : bytes(bytes) {}
+
+    uint8_t get8();
+    uint16_t get16();
+    uint32_t get32();
+    uint64_t get64();
+    WireNPC getNPC();
+    void getNPCs(std::vector<WireNPC>& out);
+    void getIds(std::vector<uint32_t>& out);
+    uint64_t getVar();
+    int64_t getSignedVar() {
+        uint64_t v = getVar();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+    const uint8_t* getBytes(size_t n) { return take(n); }
+
+    bool done() const { return pos == bytes.size(); }
+
+private:
+    const std::vector<uint8_t>& bytes;
+    size_t pos = 0;
+
+    const uint8_t* take(size_t n);
+};
+
+struct WireFrame {
+    WireMessage type = WireMessage::HELLO;
+    uint64_t tick = 0;
+    std::vector<uint8_t> payload;
+};
+
+// Отправка и прием кадра целиком (повтор при частичной записи/чтении).
+// Ошибки сокета, обрыв и чужая версия - std::runtime_error.
+// Возвращают число байт на проводе вместе с заголовком.
+size_t sendFrame(int fd, WireMessage type, uint64_t tick, const WireWriter& payload);
+size_t recvFrame(int fd, WireFrame& frame);
+
+// Unix-сокеты: слушающий (старый файл по пути удаляется), прием,
+// подключение с повторами до timeoutMillis (шард может стартовать
+// раньше координатора) и закрытие
+int listenUnix(const std::string& path, int backlog);
+int acceptUnix(int listenFd);
+int connectUnix(const std::string& path, int timeoutMillis);
+void closeSocket(int fd);
+
+#endif
@@ -0,0 +1,149 @@
+#include "world.h"
+
+NPCHandle World::add(const NPC& npc) {
+    NPCHandle h = add(npc.getName(), npc.getType(), npc.getX(), npc.getY(),
+                      npc.getHealth(), npc.getMoveDistance(), npc.getKillDistance());
+    if (!npc.isAlive()) {
+        kill(h);
+    }
+    return h;
+}
+
+NPCHandle World::add(const std::string& name, NPCType npcType, int posX, int posY,
+                     int hp, int moveDist, int killDist) {
+    NPCHandle h{static_cast<uint32_t>(x.size())};
+    x.push_back(posX);
+    y.push_back(posY);
+    backX.push_back(posX);
+    backY.push_back(posY);
+    life.push_back(NPCLife::pack(true, hp));
+
+    NPCStatics& fixed = mutableStatics();
+    fixed.type.push_back(npcType);
+    fixed.moveDistance.push_back(moveDist);
+    fixed.killDistance.push_back(killDist);
+    fixed.nameIds.push_back(encodeName(fixed.nameTable, npcType, name));
+    fixed.id.push_back(h.index);
+    return h;
+}
+
+World World::fromColumns(std::vector<int> xs, std::vector<int> ys,
+                         std::vector<uint8_t> aliveFlags, std::vector<int> healths,
+                         NPCStatics fixed) {
+    World world;
+    world.backX = xs;
+    world.backY = ys;
+    world.x = std::move(xs);
+    world.y = std::move(ys);
+    world.life.reserve(aliveFlags.size());
+    for (size_t i = 0; i < aliveFlags.size(); ++i) {
+        world.life.push_back(NPCLife::pack(aliveFlags[i] != 0, healths[i]));
+    }
+    world.statics = std::make_shared<NPCStatics>(std::move(fixed));
+    if (world.statics->id.size() != world.x.size()) {
+        world.statics->id.resize(world.x.size());
+        for (size_t i = 0; i < world.x.size(); ++i) world.statics->id[i] = static_cast<NPCId>(i);
+    }
+    return world;
+}
+
+NPCStatics& World::mutableStatics() {
+    if (statics.use_count() > 1) {
+        statics = std::make_shared<NPCStatics>(*statics);
+    }
+    return *statics;
+}
+
+void World::reserve(size_t count) {
+    x.reserve(count);
+    y.reserve(count);
+    backX.reserve(count);
+    backY.reserve(count);
+    life.reserve(count);
+
+    NPCStatics& fixed = mutableStatics();
+    fixed.type.reserve(count);
+    fixed.moveDistance.reserve(count);
+    fixed.killDistance.reserve(count);
+    fixed.nameIds.reserve(count);
+    fixed.id.reserve(count);
+}
+
+size_t World::compact() {
+    const size_t count = x.size();
+    size_t kept = 0;
+    while (kept < count && isAlive(kept)) kept++;
+    if (kept == count) return 0;
+
+    // Статику держат снимки и журнал боев - собираем новую, старую не трогаем
+    auto fixed = std::make_shared<NPCStatics>();
+    fixed->nameTable = statics->nameTable;
+    auto keepPrefix = [kept](auto& dst, const auto& src) {
+        dst.reserve(kept);
+        dst.assign(src.begin(), src.begin() + kept);
+    };
+    keepPrefix(fixed->nameIds, statics->nameIds);
+    keepPrefix(fixed->type, statics->type);
+    keepPrefix(fixed->moveDistance, statics->moveDistance);
+    keepPrefix(fixed->killDistance, statics->killDistance);
+    keepPrefix(fixed->id, statics->id);
+
+    // Горячие столбцы сжимаем на месте: живые сдвигаются к началу
+    for (size_t i = kept; i < count; ++i) {
+        const uint32_t word = lifeWord(i);
+        if (!NPCLife::alive(word)) continue;
+        x[kept] = x[i];
+        y[kept] = y[i];
+        life[kept].store(word, std::memory_order_relaxed);
+        fixed->nameIds.push_back(statics->nameIds[i]);
+        fixed->type.push_back(statics->type[i]);
+        fixed->moveDistance.push_back(statics->moveDistance[i]);
+        fixed->killDistance.push_back(statics->killDistance[i]);
+        fixed->id.push_back(statics->id[i]);
+        kept++;
+    }
+
+    x.resize(kept);
+    y.resize(kept);
+    backX.assign(x.begin(), x.end());
+    backY.assign(y.begin(), y.end());
+    life.truncate(kept);
+    statics = std::move(fixed);
+
+    removedCount += count - kept;
+    gen++;
+    return count - kept;
+}
+
+void World::move(NPCHandle h, int maxX, int maxY) {
+    if (!isAlive(h)) return;
+    NPC::step(x[h.index], y[h.index], statics->moveDistance[h.index], maxX, maxY);
+}
+
+void World::computeMoves(size_t begin, size_t end, int maxX, int maxY, Xoshiro256& gen) {
+    const std::vector<int>& moveDistance = statics->moveDistance;
+    for (size_t i = begin; i < end; ++i) {
+        int newX = x[i];
+        int newY = y[i];
+        if (isAlive(i)) {
+            NPC::step(newX, newY, moveDistance[i], maxX, maxY, gen);
+        }
+        backX[i] = newX;
+        backY[i] = newY;
+    }
+}
+
+void World::publishPositions() {
+    x.swap(backX);
+    y.swap(backY);
+}
+
+NPC World::view(NPCHandle h) const {
+    const uint32_t word = lifeWord(h.index);
+    NPC npc(getName(h), getType(h), x[h.index], y[h.index],
+            NPCLife::health(word), getMoveDistance(h), getKillDistance(h));
+    if (!NPCLife::alive(word)) {
+        npc.kill();
+    }
+    return npc;
+}
@@ -0,0 +1,218 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "npc.h"
+#include "names.h"
+#include "atomic_column.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 32-битный номер NPC в мире; журнал, бои и снимки передают только его
+using NPCId = uint32_t;
+
+// Дескриптор NPC в World (вместо shared_ptr<NPC>). Индекс действителен,
+// пока поколение мира не сменилось: сжатие перенумеровывает NPC, и
+// дескриптор старого поколения надо отбросить (World::current).
+struct NPCHandle {
+    NPCId index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != UINT32_MAX; }
+    bool operator==(const NPCHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const NPCHandle& other) const { return !(*this == other); }
+};
+
+// Неизменяемые после создания свойства NPC. World делит их со снимками
+// мира, поэтому снимок копирует только то, что меняется по тикам.
+// Имя хранится как 32-битный NameId; строка собирается только для вывода.
+struct NPCStatics {
+    std::vector<NameId> nameIds;
+    NameTable nameTable;
+    std::vector<NPCType> type;
+    std::vector<int> moveDistance;
+    std::vector<int> killDistance;
+    std::vector<NPCId> id;  // номер NPC при создании мира; сжатие его не меняет
+
+    std::string name(size_t i) const { return decodeName(nameIds[i], type[i], nameTable); }
+    void appendName(std::string& out, size_t i) const {
+        ::appendName(out, nameIds[i], type[i], nameTable);
+    }
+};
+
+// Жизнь NPC в одном атомарном слове: старший бит - жив, следующий -
+// NPC занят в бою (World::tryFight), остальные - здоровье. Потоки боев
+// меняют его без блокировок, движение и поиск пар читают его
+// одновременно с ними без гонок.
+struct NPCLife {
+    static constexpr uint32_t ALIVE = 0x80000000u;
+    static constexpr uint32_t ENGAGED = 0x40000000u;
+    static constexpr uint32_t HEALTH = 0x3fffffffu;
+
+    static constexpr uint32_t pack(bool alive, int health) {
+        return (alive ? ALIVE : 0u) | (static_cast<uint32_t>(health < 0 ? 0 : health) & HEALTH);
+    }
+    static constexpr bool alive(uint32_t word) { return (word & ALIVE) != 0; }
+    static constexpr bool engaged(uint32_t word) { return (word & ENGAGED) != 0; }
+    static constexpr int health(uint32_t word) { return static_cast<int>(word & HEALTH); }
+};
+
+// Хранилище мира в виде структуры массивов: горячие поля лежат
+// подряд, и циклы движения и поиска пар не прыгают по указателям.
+// Мертвые NPC остаются на месте до compact(); сжатие сохраняет порядок
+// живых, но меняет их индексы и поколение мира.
+//
+// Позиции двойные: движение пишет новые координаты в задний буфер
+// (computeMoves), а publishPositions одним обменом делает их текущими.
+// До обмена читатели видят согласованные позиции прошлого тика.
+// Позиции пишет только поток движения, поэтому они обычные int (их
+// читает векторное ядро); жизнь и здоровье - атомарные слова NPCLife.
+class World {
+private:
+    std::vector<int> x, y;
+    std::vector<int> backX, backY;
+    AtomicColumn<uint32_t> life;
+    std::shared_ptr<NPCStatics> statics = std::make_shared<NPCStatics>();
+    uint32_t gen = 0;
+    size_t removedCount = 0;
+
+    // Копия при записи: статику, которую держит снимок, не меняем
+    NPCStatics& mutableStatics();
+
+    // Захват живого NPC для боя; занятого другим боем ждем (бой короткий).
+    // false - NPC мертв.
+    bool engage(uint32_t i) {
+        uint32_t word = life[i].load(std::memory_order_acquire);
+        for (unsigned spins = 0;; ++spins) {
+            if (!NPCLife::alive(word)) return false;
+            if (NPCLife::engaged(word)) {
+                if (spins >= 64) std::this_thread::yield();
+                word = life[i].load(std::memory_order_acquire);
+                continue;
+            }
+            if (life[i].compare_exchange_weak(word, word | NPCLife::ENGAGED,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+                return true;
+            }
+        }
+    }
+    void disengage(uint32_t i) {
+        life[i].fetch_and(~NPCLife::ENGAGED, std::memory_order_release);
+    }
+
+public:
+    NPCHandle add(const NPC& npc);
+    NPCHandle add(const std::string& name, NPCType type, int x, int y,
+                  int health, int moveDist, int killDist);
+
+    // Мир целиком из готовых столбцов (загрузка снимка с диска)
+    static World fromColumns(std::vector<int> xs, std::vector<int> ys,
+                             std::vector<uint8_t> alive, std::vector<int> health,
+                             NPCStatics statics);
+
+    void reserve(size_t count);
+    size_t size() const { return x.size(); }
+    NPCHandle handle(size_t index) const { return NPCHandle{static_cast<uint32_t>(index), gen}; }
+
+    // Поколение растет при каждом сжатии; дескриптор годен только в своем.
+    // current() зовут потоки боев без npcsMutex, поэтому индекс сверяется
+    // с длиной столбца жизни: она меняется только в compact(), пока пул
+    // боев приостановлен, а x/y в это время меняет publishPositions.
+    uint32_t generation() const { return gen; }
+    bool current(NPCHandle h) const { return h.generation == gen && h.index < life.size(); }
+
+    // Удаляет мертвых NPC, сохраняя порядок живых (стабильное разбиение).
+    // Возвращает число удаленных; если оно не 0, поколение сменилось.
+    // Мир в это время не должен читать и менять никто другой.
+    size_t compact();
+
+    // Мертвых удалено сжатиями за все время
+    size_t removed() const { return removedCount; }
+    NPCId stableId(NPCHandle h) const { return statics->id[h.index]; }
+
+    // Доступ к отдельному NPC
+    std::string getName(NPCHandle h) const { return statics->name(h.index); }
+    NPCType getType(NPCHandle h) const { return statics->type[h.index]; }
+    int getX(NPCHandle h) const { return x[h.index]; }
+    int getY(NPCHandle h) const { return y[h.index]; }
+    int getHealth(NPCHandle h) const { return NPCLife::health(lifeWord(h.index)); }
+    bool isAlive(NPCHandle h) const { return NPCLife::alive(lifeWord(h.index)); }
+    bool isAlive(size_t i) const { return NPCLife::alive(lifeWord(i)); }
+    uint32_t lifeWord(size_t i) const { return life[i].load(std::memory_order_acquire); }
+    int getMoveDistance(NPCHandle h) const { return statics->moveDistance[h.index]; }
+    int getKillDistance(NPCHandle h) const { return statics->killDistance[h.index]; }
+
+    void setPosition(NPCHandle h, int newX, int newY) {
+        x[h.index] = newX;
+        y[h.index] = newY;
+    }
+
+    void kill(NPCHandle h) {
+        life[h.index].store(NPCLife::pack(false, 0), std::memory_order_release);
+    }
+
+    // Убивает живого NPC. Из нескольких одновременных вызовов ровно
+    // один получает true; NPC, занятого в бою, не трогает до конца боя.
+    bool tryKill(NPCHandle h) {
+        if (!engage(h.index)) return false;
+        life[h.index].store(NPCLife::pack(false, 0), std::memory_order_release);
+        return true;
+    }
+
+    // Бой двух NPC: оба захватываются в порядке индексов (без взаимных
+    // блокировок), и проигравший убивается, только если оба живы, -
+    // мертвый NPC не может победить. onKill(loser) зовется, пока оба
+    // захвачены, поэтому порядок его вызовов совпадает с порядком смертей.
+    // false - один из участников уже мертв, бой не состоялся.
+    template <typename OnKill>
+    bool tryFight(NPCHandle attacker, NPCHandle defender, bool attackerWins, OnKill&& onKill) {
+        if (attacker.index == defender.index) return false;
+        const uint32_t first = std::min(attacker.index, defender.index);
+        const uint32_t second = std::max(attacker.index, defender.index);
+        if (!engage(first)) return false;
+        if (!engage(second)) {
+            disengage(first);
+            return false;
+        }
+        const NPCHandle winner = attackerWins ? attacker : defender;
+        const NPCHandle loser = attackerWins ? defender : attacker;
+        onKill(loser);
+        life[loser.index].store(NPCLife::pack(false, 0), std::memory_order_release);
+        disengage(winner.index);
+        return true;
+    }
+
+    // Случайный шаг живого NPC в пределах карты (сразу в текущие позиции)
+    void move(NPCHandle h, int maxX, int maxY);
+
+    // Шаги NPC [begin, end) в задний буфер; разные диапазоны можно
+    // считать параллельно
+    void computeMoves(size_t begin, size_t end, int maxX, int maxY, Xoshiro256& gen);
+
+    // Делает задний буфер текущим (O(1))
+    void publishPositions();
+
+    // Копия NPC для toString и тестов
+    NPC view(NPCHandle h) const;
+
+    // Массивы целиком - для пакетной обработки
+    const std::vector<int>& xs() const { return x; }
+    const std::vector<int>& ys() const { return y; }
+    const std::vector<NPCType>& types() const { return statics->type; }
+    const std::vector<int>& moveDistances() const { return statics->moveDistance; }
+    const std::vector<int>& killDistances() const { return statics->killDistance; }
+    const std::vector<NPCId>& ids() const { return statics->id; }
+
+    // Позиции до последнего publishPositions (сдвиги тика для журнала)
+    const std::vector<int>& previousXs() const { return backX; }
+    const std::vector<int>& previousYs() const { return backY; }
+    std::shared_ptr<const NPCStatics> sharedStatics() const { return statics; }
+};
+
+#endif
@@ -0,0 +1,259 @@
+#include "world_file.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint64_t SECTION_ALIGN = 8;
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + SECTION_ALIGN - 1) & ~(SECTION_ALIGN - 1);
+}
+
+void fail(const std::string& path, const std::string& reason) {
+    throw std::runtime_error("bad world file " + path + ": " + reason);
+}
+
+}
+
+WorldFile::WorldFile(const std::string& path) {
+#ifdef _WIN32
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) fail(path, "cannot open");
+    buffer.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    data = buffer.data();
+    size = buffer.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) fail(path, "cannot open");
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        fail(path, "cannot stat");
+    }
+    size = static_cast<size_t>(st.st_size);
+    if (size > 0) {
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            fail(path, "mmap failed");
+        }
+        data = static_cast<const unsigned char*>(mapped);
+        // Столбцы читаются подряд - подскажем ядру читать вперед
+        ::madvise(mapped, size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+#endif
+
+    try {
+        validate(path);
+    } catch (...) {
+#ifndef _WIN32
+        if (data) ::munmap(const_cast<unsigned char*>(data), size);
+#endif
+        throw;
+    }
+}
+
+WorldFile::~WorldFile() {
+#ifndef _WIN32
+    if (data) ::munmap(const_cast<unsigned char*>(data), size);
+#endif
+}
+
+void WorldFile::validate(const std::string& path) {
+    if (size < sizeof(WorldFileHeader)) fail(path, "truncated header");
+    hdr = reinterpret_cast<const WorldFileHeader*>(data);
+
+    if (std::memcmp(hdr->magic, WORLD_FILE_MAGIC, sizeof(WORLD_FILE_MAGIC)) != 0) {
+        fail(path, "not a world snapshot");
+    }
+    if (hdr->version != WORLD_FILE_VERSION) {
+        fail(path, "unsupported version " + std::to_string(hdr->version));
+    }
+    if (hdr->headerSize != sizeof(WorldFileHeader)) fail(path, "layout mismatch");
+    if (hdr->mapX <= 0 || hdr->mapY <= 0) fail(path, "bad map size");
+    if (hdr->typeCount > 256) fail(path, "too many types");
+
+    auto within = [this](uint64_t offset, uint64_t bytes) {
+        return offset % SECTION_ALIGN == 0 && offset <= size && bytes <= size - offset;
+    };
+    const uint64_t count = hdr->npcCount;
+    // Шесть 4-байтовых и два байтовых столбца: без переполнения в размерах
+    if (count > size / (6 * sizeof(int32_t) + 2)) fail(path, "section out of bounds");
+    const uint64_t words = count * sizeof(int32_t);
+    if (!within(hdr->typeTableOffset, uint64_t{hdr->typeCount} * sizeof(WorldFileType)) ||
+        !within(hdr->xOffset, words) || !within(hdr->yOffset, words) ||
+        !within(hdr->healthOffset, words) || !within(hdr->moveDistanceOffset, words) ||
+        !within(hdr->killDistanceOffset, words) || !within(hdr->nameIdOffset, words) ||
+        !within(hdr->typeOffset, count) || !within(hdr->aliveOffset, count) ||
+        !within(hdr->nameOffsetsOffset, (uint64_t{hdr->nameCount} + 1) * sizeof(uint32_t)) ||
+        !within(hdr->nameDataOffset, hdr->nameDataSize)) {
+        fail(path, "section out of bounds");
+    }
+
+    // Коды типов в файле сопоставляются по имени, а не по номеру в enum
+    const auto* types = column<WorldFileType>(hdr->typeTableOffset);
+    typeMap.resize(hdr->typeCount);
+    for (uint32_t t = 0; t < hdr->typeCount; ++t) {
+        std::string name(types[t].name, strnlen(types[t].name, sizeof(types[t].name)));
+        typeMap[t] = NPC::stringToType(name);
+        if (typeMap[t] == NPCType::UNKNOWN) fail(path, "unknown NPC type " + name);
+    }
+
+    const uint32_t* nameOffsets = column<uint32_t>(hdr->nameOffsetsOffset);
+    const char* nameData = column<char>(hdr->nameDataOffset);
+    nameTable.reserve(hdr->nameCount);
+    for (uint32_t k = 0; k < hdr->nameCount; ++k) {
+        if (nameOffsets[k] > nameOffsets[k + 1] || nameOffsets[k + 1] > hdr->nameDataSize) {
+            fail(path, "bad name table");
+        }
+        const std::string name(nameData + nameOffsets[k], nameOffsets[k + 1] - nameOffsets[k]);
+        if (nameTable.intern(name) != (k | INTERNED_NAME)) fail(path, "duplicate name " + name);
+    }
+
+    // Столбцы-ссылки проверяются один раз, чтобы load() копировал их не глядя
+    const uint8_t* typeCodes = column<uint8_t>(hdr->typeOffset);
+    const uint32_t* nameIds = column<uint32_t>(hdr->nameIdOffset);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (typeCodes[i] >= hdr->typeCount ||
+            ((nameIds[i] & INTERNED_NAME) && (nameIds[i] & ~INTERNED_NAME) >= hdr->nameCount)) {
+            fail(path, "bad record " + std::to_string(i));
+        }
+    }
+}
+
+std::string WorldFile::name(size_t i) const {
+    return decodeName(column<uint32_t>(hdr->nameIdOffset)[i], type(i), nameTable);
+}
+
+LoadedWorld WorldFile::load() const {
+    const size_t count = npcCount();
+    auto copy = [count](const auto* column) {
+        using T = std::remove_cv_t<std::remove_pointer_t<decltype(column)>>;
+        return std::vector<T>(column, column + count);
+    };
+
+    NPCStatics fixed;
+    fixed.moveDistance = copy(column<int32_t>(hdr->moveDistanceOffset));
+    fixed.killDistance = copy(column<int32_t>(hdr->killDistanceOffset));
+    fixed.nameIds = copy(column<uint32_t>(hdr->nameIdOffset));
+    fixed.nameTable = nameTable;
+    // NPCType шире байта кода: это перекодировка, а не разбор
+    const uint8_t* typeCodes = column<uint8_t>(hdr->typeOffset);
+    fixed.type.resize(count);
+    std::transform(typeCodes, typeCodes + count, fixed.type.begin(),
+                   [this](uint8_t code) { return typeMap[code]; });
+
+    LoadedWorld loaded;
+    loaded.world = World::fromColumns(copy(xs()), copy(ys()), copy(alive()), copy(healths()),
+                                      std::move(fixed));
+    loaded.tick = hdr->tick;
+    loaded.mapX = hdr->mapX;
+    loaded.mapY = hdr->mapY;
+    return loaded;
+}
+
+void WorldFile::save(const std::string& path, const WorldSnapshot& snapshot) {
+    const NPCStatics& fixed = *snapshot.statics;
+    const size_t count = snapshot.size();
+    const uint64_t words = count * sizeof(int32_t);
+
+    WorldFileHeader header{};
+    std::memcpy(header.magic, WORLD_FILE_MAGIC, sizeof(WORLD_FILE_MAGIC));
+    header.version = WORLD_FILE_VERSION;
+    header.headerSize = sizeof(WorldFileHeader);
+    header.tick = snapshot.tick;
+    header.mapX = snapshot.mapX;
+    header.mapY = snapshot.mapY;
+    header.npcCount = count;
+    header.typeCount = static_cast<uint32_t>(NPC_TYPE_COUNT);
+    header.nameCount = static_cast<uint32_t>(fixed.nameTable.size());
+    header.typeTableOffset = alignUp(sizeof(WorldFileHeader));
+    header.xOffset = alignUp(header.typeTableOffset + NPC_TYPE_COUNT * sizeof(WorldFileType));
+    header.yOffset = alignUp(header.xOffset + words);
+    header.healthOffset = alignUp(header.yOffset + words);
+    header.moveDistanceOffset = alignUp(header.healthOffset + words);
+    header.killDistanceOffset = alignUp(header.moveDistanceOffset + words);
+    header.nameIdOffset = alignUp(header.killDistanceOffset + words);
+    header.typeOffset = alignUp(header.nameIdOffset + words);
+    header.aliveOffset = alignUp(header.typeOffset + count);
+    header.nameOffsetsOffset = alignUp(header.aliveOffset + count);
+    header.nameDataOffset =
+        alignUp(header.nameOffsetsOffset + (uint64_t{header.nameCount} + 1) * sizeof(uint32_t));
+
+    std::vector<WorldFileType> types(NPC_TYPE_COUNT);
+    for (size_t t = 0; t < NPC_TYPE_COUNT; ++t) {
+        std::string name = NPC::typeToString(static_cast<NPCType>(t));
+        std::strncpy(types[t].name, name.c_str(), sizeof(types[t].name) - 1);
+    }
+
+    // Байтовые столбцы: код типа - номер в таблице типов выше
+    std::vector<uint8_t> typeCodes(count);
+    for (size_t i = 0; i < count; ++i) typeCodes[i] = static_cast<uint8_t>(fixed.type[i]);
+
+    std::vector<uint32_t> nameOffsets;
+    nameOffsets.reserve(header.nameCount + 1);
+    std::string nameData;
+    for (uint32_t k = 0; k < header.nameCount; ++k) {
+        nameOffsets.push_back(static_cast<uint32_t>(nameData.size()));
+        nameData += fixed.nameTable.str(k | INTERNED_NAME);
+        if (nameData.size() > UINT32_MAX) {
+            throw std::runtime_error("world snapshot names do not fit the file format");
+        }
+    }
+    nameOffsets.push_back(static_cast<uint32_t>(nameData.size()));
+    header.nameDataSize = nameData.size();
+
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("cannot write world file: " + tmpPath);
+
+        static const char zeros[SECTION_ALIGN] = {};
+        auto padTo = [&out](uint64_t offset) {
+            uint64_t at = static_cast<uint64_t>(out.tellp());
+            out.write(zeros, static_cast<std::streamsize>(offset - at));
+        };
+
+        auto writeColumn = [&](uint64_t offset, const auto& column) {
+            padTo(offset);
+            out.write(reinterpret_cast<const char*>(column.data()),
+                      static_cast<std::streamsize>(column.size() * sizeof(column[0])));
+        };
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeColumn(header.typeTableOffset, types);
+        writeColumn(header.xOffset, snapshot.x);
+        writeColumn(header.yOffset, snapshot.y);
+        writeColumn(header.healthOffset, snapshot.health);
+        writeColumn(header.moveDistanceOffset, fixed.moveDistance);
+        writeColumn(header.killDistanceOffset, fixed.killDistance);
+        writeColumn(header.nameIdOffset, fixed.nameIds);
+        writeColumn(header.typeOffset, typeCodes);
+        writeColumn(header.aliveOffset, snapshot.alive);
+        writeColumn(header.nameOffsetsOffset, nameOffsets);
+        writeColumn(header.nameDataOffset, nameData);
+        if (!out) throw std::runtime_error("cannot write world file: " + tmpPath);
+    }
+
+#ifdef _WIN32
+    std::remove(path.c_str());  // rename на Windows не заменяет существующий файл
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("cannot rename world file to " + path);
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef WORLD_FILE_H
+#define WORLD_FILE_H
+
+#include "world.h"
+#include "names.h"
+#include "snapshot.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Двоичный снимок мира на диске. Раскладка фиксированная, порядок байт -
+// родной для машины (файл переносим между x86/ARM little-endian).
+// Файл хранит мир так же, как World, - столбцами:
+//
+//   WorldFileHeader                       (заголовок, версия, смещения)
+//   WorldFileType[typeCount]              (имена типов: код в файле -> NPCType)
+//   int32 x, y, health, moveDistance, killDistance [npcCount]
+//   uint32 nameId[npcCount]               (NameId, names.h)
+//   uint8 type, alive [npcCount]
+//   uint32 nameOffsets[nameCount + 1]     (таблица интернированных имен)
+//   char nameData[nameDataSize]
+//
+// Секции выровнены по 8 байт. Загрузка копирует столбцы целиком, без
+// разбора записей; строки собираются только для интернированных имен,
+// сгенерированные ("<Тип>_<номер>") хранятся номером в nameId.
+
+constexpr char WORLD_FILE_MAGIC[8] = {'L', 'A', 'B', '7', 'W', 'R', 'L', 'D'};
+constexpr uint32_t WORLD_FILE_VERSION = 2;
+
+struct WorldFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t tick;
+    int32_t mapX;
+    int32_t mapY;
+    uint64_t npcCount;
+    uint32_t typeCount;
+    uint32_t nameCount;
+    uint64_t typeTableOffset;
+    uint64_t xOffset;
+    uint64_t yOffset;
+    uint64_t healthOffset;
+    uint64_t moveDistanceOffset;
+    uint64_t killDistanceOffset;
+    uint64_t nameIdOffset;
+    uint64_t typeOffset;
+    uint64_t aliveOffset;
+    uint64_t nameOffsetsOffset;
+    uint64_t nameDataOffset;
+    uint64_t nameDataSize;
+};
+
+struct WorldFileType {
+    char name[16];  // "Orc", "Squirrel", ... (с нулем в конце)
+};
+
+static_assert(sizeof(WorldFileHeader) == 144, "WorldFileHeader layout changed");
+static_assert(sizeof(WorldFileType) == 16, "WorldFileType layout changed");
+
+// Загруженный мир вместе с параметрами карты
+struct LoadedWorld {
+    World world;
+    uint64_t tick = 0;
+    int mapX = 0;
+    int mapY = 0;
+};
+
+// Файл снимка, отображенный в память только для чтения. Конструктор
+// проверяет заголовок и границы секций и бросает std::runtime_error,
+// если файл поврежден или другой версии.
+class WorldFile {
+public:
+    explicit WorldFile(const std::string& path);
+    ~WorldFile();
+
+    WorldFile(const WorldFile&) = delete;
+    WorldFile& operator=(const WorldFile&) = delete;
+
+    const WorldFileHeader& header() const { return *hdr; }
+    size_t npcCount() const { return static_cast<size_t>(hdr->npcCount); }
+
+    // Столбцы отображенного файла
+    const int32_t* xs() const { return column<int32_t>(hdr->xOffset); }
+    const int32_t* ys() const { return column<int32_t>(hdr->yOffset); }
+    const int32_t* healths() const { return column<int32_t>(hdr->healthOffset); }
+    const uint8_t* alive() const { return column<uint8_t>(hdr->aliveOffset); }
+    NPCType type(size_t i) const { return typeMap[column<uint8_t>(hdr->typeOffset)[i]]; }
+    std::string name(size_t i) const;
+
+    // Копия содержимого в World: столбцы копируются целиком
+    LoadedWorld load() const;
+
+    // Сохраняет снимок мира; пишет во временный файл и переименовывает,
+    // так что читатель никогда не увидит недописанный снимок
+    static void save(const std::string& path, const WorldSnapshot& snapshot);
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    std::vector<unsigned char> buffer;  // без mmap файл читается целиком
+#endif
+
+    const WorldFileHeader* hdr = nullptr;
+    std::vector<NPCType> typeMap;
+    NameTable nameTable;  // интернированные имена (обычно их нет)
+
+    template <typename T>
+    const T* column(uint64_t offset) const { return reinterpret_cast<const T*>(data + offset); }
+
+    void validate(const std::string& path);
+};
+
+#endif